@@ -0,0 +1,405 @@
+/// Copyright 2017 Lucas Saldyt
+#include "astfile.hpp"
+#include "../syntax/symbols/export.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace ast
+{
+
+namespace
+{
+    size_t align8(size_t offset)
+    {
+        return (offset + 7) / 8 * 8;
+    }
+
+    /**
+     * Flattens symbols into the node, entry and child arrays of a binary AST
+     * Symbols referenced from several places (i.e. after a copy transform) are only written once
+     */
+    class ASTWriter
+    {
+    public:
+        ASTWriter(const TokenStream* tokens)
+        {
+            for (int i = 0; tokens and i < tokens->size(); i++)
+            {
+                if (auto symbol = tokens->cachedSymbol(i))
+                {
+                    token_positions[symbol] = i;
+                }
+            }
+        }
+
+        vector<string>   strings;
+        vector<ASTNode>  nodes;
+        vector<ASTEntry> entries;
+        vector<uint32_t> children;
+
+        uint32_t addString(const string& s)
+        {
+            auto found = string_ids.find(s);
+            if (found != string_ids.end())
+            {
+                return found->second;
+            }
+            uint32_t id = strings.size();
+            strings.push_back(s);
+            string_ids[s] = id;
+            return id;
+        }
+
+        uint32_t addSymbol(Symbol* symbol)
+        {
+            auto found = node_ids.find(symbol);
+            if (found != node_ids.end())
+            {
+                return found->second;
+            }
+            uint32_t id;
+            if (auto multisymbol = dynamic_cast<MultiSymbol*>(symbol))
+            {
+                id = addTable(NodeKind::multisymbol, multisymbol->tag, multisymbol->table, multisymbol->line);
+            }
+            else if (auto identifier = dynamic_cast<Identifier*>(symbol)) // Before StringLiteral, which it derives from
+            {
+                id = addLeaf(symbol, NodeKind::identifier, 0, addString(identifier->value));
+            }
+            else if (auto literal = dynamic_cast<StringLiteral*>(symbol))
+            {
+                id = addLeaf(symbol, NodeKind::string_literal, 0, addString(literal->value));
+            }
+            else if (auto integer = dynamic_cast<Integer*>(symbol))
+            {
+                id = addLeaf(symbol, NodeKind::integer, 0, (uint64_t)(int64_t)integer->value);
+            }
+            else if (auto real = dynamic_cast<Double*>(symbol))
+            {
+                uint64_t bits;
+                std::memcpy(&bits, &real->value, sizeof(bits));
+                id = addLeaf(symbol, NodeKind::real, 0, bits);
+            }
+            else if (auto sentinel = dynamic_cast<SentinelSymbol*>(symbol))
+            {
+                id = addLeaf(symbol, NodeKind::sentinel, addString(sentinel->tag), addString(sentinel->val));
+            }
+            else
+            {
+                throw named_exception("Cannot serialize symbol: " + symbol->abstract());
+            }
+            node_ids[symbol] = id;
+            return id;
+        }
+
+        /// Children are added first, so they always precede their parent
+        uint32_t addTable(NodeKind kind, const string& tag, const MultiSymbolTable& table, int line)
+        {
+            vector<vector<uint32_t>> child_ids;
+            for (auto kv : table)
+            {
+                child_ids.emplace_back();
+                for (auto symbol : kv.second)
+                {
+                    child_ids.back().push_back(addSymbol(symbol));
+                }
+            }
+            uint32_t first_entry = entries.size();
+            int i = 0;
+            for (auto kv : table)
+            {
+                entries.push_back(ASTEntry{addString(interned(kv.first)), (uint32_t)children.size(), (uint32_t)child_ids[i].size()});
+                children.insert(children.end(), child_ids[i].begin(), child_ids[i].end());
+                i++;
+            }
+            nodes.push_back(ASTNode{kind, addString(tag), first_entry, (uint32_t)table.size(), -1, line, 0});
+            return nodes.size() - 1;
+        }
+
+    private:
+        unordered_map<string, uint32_t> string_ids;
+        unordered_map<Symbol*, uint32_t> node_ids;
+        unordered_map<Symbol*, int>      token_positions;
+
+        uint32_t addLeaf(Symbol* symbol, NodeKind kind, uint32_t tag, uint64_t value)
+        {
+            auto found = token_positions.find(symbol);
+            int token  = found == token_positions.end() ? -1 : found->second;
+            nodes.push_back(ASTNode{kind, tag, 0, 0, token, symbol->line, value});
+            return nodes.size() - 1;
+        }
+    };
+
+    void writePadded(std::ofstream& file, const void* data, size_t size)
+    {
+        static const char zeros[8] = {};
+        file.write((const char*)data, size);
+        file.write(zeros, align8(size) - size);
+    }
+}
+
+/**
+ * Serialize identified groups to a binary AST file
+ * @param identified_groups Groups to write, i.e. the universal AST of a file
+ * @param filename          Path to write to
+ * @param tokens            Stream the groups were identified from, if any. Leaves record the token they were built from,
+ *                          so a loader can rebuild them from a stream with different token text (see load())
+ */
+void writeAST(const IdentifiedGroups& identified_groups, string filename, const TokenStream* tokens)
+{
+    ASTWriter writer(tokens);
+    vector<uint32_t> groups;
+    for (const auto& identified_group : identified_groups)
+    {
+        groups.push_back(writer.addTable(NodeKind::group, get<0>(identified_group), get<1>(identified_group), -1));
+    }
+
+    vector<uint32_t> string_offsets(1, 0);
+    string string_bytes;
+    for (const auto& s : writer.strings)
+    {
+        string_bytes += s;
+        string_offsets.push_back(string_bytes.size());
+    }
+
+    ASTHeader header;
+    std::memcpy(header.magic, ast_magic, sizeof(ast_magic));
+    header.version      = ast_version;
+    header.string_count = writer.strings.size();
+    header.string_bytes = string_bytes.size();
+    header.node_count   = writer.nodes.size();
+    header.entry_count  = writer.entries.size();
+    header.child_count  = writer.children.size();
+    header.group_count  = groups.size();
+    header.reserved     = 0;
+
+    std::ofstream file(filename, std::ios::binary);
+    err_if(not file, "Could not open " + filename + " for writing");
+    writePadded(file, &header, sizeof(header));
+    writePadded(file, string_offsets.data(), string_offsets.size() * sizeof(uint32_t));
+    writePadded(file, string_bytes.data(),   string_bytes.size());
+    writePadded(file, writer.nodes.data(),    writer.nodes.size()    * sizeof(ASTNode));
+    writePadded(file, writer.entries.data(),  writer.entries.size()  * sizeof(ASTEntry));
+    writePadded(file, writer.children.data(), writer.children.size() * sizeof(uint32_t));
+    writePadded(file, groups.data(),          groups.size()          * sizeof(uint32_t));
+    err_if(not file, "Failed to write " + filename);
+}
+
+/**
+ * Map a binary AST file into memory, checking that it is well formed
+ * @param set_filename File written by writeAST
+ */
+ASTFile::ASTFile(string set_filename) :
+    filename(set_filename)
+{
+    int descriptor = open(filename.c_str(), O_RDONLY);
+    err_if(descriptor < 0, "Could not open AST file " + filename);
+    struct stat info;
+    if (fstat(descriptor, &info) == 0 and info.st_size > 0)
+    {
+        size = info.st_size;
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        data = mapped == MAP_FAILED ? nullptr : (const char*)mapped;
+    }
+    close(descriptor);
+    err_if(data == nullptr, "Could not map AST file " + filename);
+    try
+    {
+        validate();
+    }
+    catch (...)
+    {
+        munmap((void*)data, size);
+        throw;
+    }
+}
+
+ASTFile::~ASTFile()
+{
+    munmap((void*)data, size);
+}
+
+/// Locate each section and check every index in the file, so accessors and load() can trust them
+void ASTFile::validate()
+{
+    auto invalid = [this](string reason){ return named_exception("Invalid AST file " + filename + ": " + reason); };
+    if (size < sizeof(ASTHeader) or std::memcmp(header().magic, ast_magic, sizeof(ast_magic)) != 0)
+    {
+        throw invalid("not a binary AST");
+    }
+    const auto& h = header();
+    if (h.version != ast_version)
+    {
+        throw invalid("version " + std::to_string(h.version) + ", expected " + std::to_string(ast_version));
+    }
+
+    size_t offset = align8(sizeof(ASTHeader));
+    auto section = [&](size_t bytes)
+    {
+        size_t start = offset;
+        offset = align8(offset + bytes);
+        if (offset > size)
+        {
+            throw invalid("truncated");
+        }
+        return data + start;
+    };
+    string_offsets = (const uint32_t*)section(((size_t)h.string_count + 1) * sizeof(uint32_t));
+    string_bytes   = section(h.string_bytes);
+    nodes          = (const ASTNode*) section((size_t)h.node_count  * sizeof(ASTNode));
+    entries        = (const ASTEntry*)section((size_t)h.entry_count * sizeof(ASTEntry));
+    children       = (const uint32_t*)section((size_t)h.child_count * sizeof(uint32_t));
+    groups         = (const uint32_t*)section((size_t)h.group_count * sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < h.string_count; i++)
+    {
+        if (string_offsets[i] > string_offsets[i + 1] or string_offsets[i + 1] > h.string_bytes)
+        {
+            throw invalid("bad string table");
+        }
+    }
+    for (uint32_t i = 0; i < h.node_count; i++)
+    {
+        const auto& n = nodes[i];
+        bool has_entries = n.kind == NodeKind::multisymbol or n.kind == NodeKind::group;
+        bool text_value  = n.kind == NodeKind::string_literal or n.kind == NodeKind::identifier or n.kind == NodeKind::sentinel;
+        if (n.kind > NodeKind::group or n.tag >= h.string_count or (text_value and n.value >= h.string_count) or
+            (not has_entries and n.entry_count != 0) or (uint64_t)n.first_entry + n.entry_count > h.entry_count)
+        {
+            throw invalid("bad node " + std::to_string(i));
+        }
+        for (uint32_t e = n.first_entry; e < n.first_entry + n.entry_count; e++)
+        {
+            const auto& en = entries[e];
+            if (en.tag >= h.string_count or (uint64_t)en.first_child + en.child_count > h.child_count)
+            {
+                throw invalid("bad entry " + std::to_string(e));
+            }
+            for (uint32_t c = en.first_child; c < en.first_child + en.child_count; c++)
+            {
+                if (children[c] >= i or nodes[children[c]].kind == NodeKind::group) // Also rules out cycles
+                {
+                    throw invalid("bad child of node " + std::to_string(i));
+                }
+            }
+        }
+    }
+    for (uint32_t i = 0; i < h.group_count; i++)
+    {
+        if (groups[i] >= h.node_count or nodes[groups[i]].kind != NodeKind::group)
+        {
+            throw invalid("bad group " + std::to_string(i));
+        }
+    }
+}
+
+const ASTHeader& ASTFile::header() const
+{
+    return *(const ASTHeader*)data;
+}
+
+std::string_view ASTFile::text(uint32_t index) const
+{
+    return std::string_view(string_bytes + string_offsets[index], string_offsets[index + 1] - string_offsets[index]);
+}
+
+const ASTNode& ASTFile::node(uint32_t index) const
+{
+    return nodes[index];
+}
+
+const ASTEntry& ASTFile::entry(uint32_t index) const
+{
+    return entries[index];
+}
+
+uint32_t ASTFile::child(uint32_t index) const
+{
+    return children[index];
+}
+
+uint32_t ASTFile::group(uint32_t index) const
+{
+    return groups[index];
+}
+
+/**
+ * Construct the symbols of the file
+ * Nodes are built in file order, which puts children before their parents, and shared nodes are only built once
+ * @param arena  Arena to construct the symbols in
+ * @param tokens Optionally, a stream with the same token types as the one the file was written from.
+ *               Leaves that came from a token are taken from this stream instead, i.e. with another symbol table applied
+ * @return Identified groups, as they were when written
+ */
+IdentifiedGroups ASTFile::load(Arena& arena, TokenStream* tokens) const
+{
+    vector<Symbol*> symbols(header().node_count, nullptr);
+    for (uint32_t i = 0; i < header().node_count; i++)
+    {
+        const auto& n = nodes[i];
+        if (tokens and n.token >= 0)
+        {
+            err_if(n.token >= tokens->size(), "AST file " + filename + " does not match its token stream");
+            symbols[i] = tokens->symbol(n.token);
+            continue;
+        }
+        switch (n.kind)
+        {
+            case NodeKind::string_literal:
+                symbols[i] = arena.make<StringLiteral>(std::string(text(n.value)));
+                break;
+            case NodeKind::identifier:
+                symbols[i] = arena.make<Identifier>(std::string(text(n.value)));
+                break;
+            case NodeKind::integer:
+                symbols[i] = arena.make<Integer>((int)(int64_t)n.value);
+                break;
+            case NodeKind::real:
+            {
+                double value;
+                std::memcpy(&value, &n.value, sizeof(value));
+                symbols[i] = arena.make<Double>(value);
+                break;
+            }
+            case NodeKind::multisymbol:
+                symbols[i] = arena.make<MultiSymbol>(std::string(text(n.tag)), loadTable(n, symbols));
+                break;
+            case NodeKind::sentinel:
+                symbols[i] = arena.make<SentinelSymbol>(std::string(text(n.tag)), std::string(text(n.value)));
+                break;
+            case NodeKind::group: // Built below, groups are not symbols
+                break;
+        }
+        if (symbols[i] != nullptr)
+        {
+            symbols[i]->line = n.line;
+        }
+    }
+
+    IdentifiedGroups identified_groups;
+    for (uint32_t i = 0; i < header().group_count; i++)
+    {
+        const auto& n = nodes[groups[i]];
+        identified_groups.push_back(make_tuple(std::string(text(n.tag)), loadTable(n, symbols)));
+    }
+    return identified_groups;
+}
+
+MultiSymbolTable ASTFile::loadTable(const ASTNode& n, const vector<Symbol*>& symbols) const
+{
+    MultiSymbolTable table;
+    for (uint32_t e = n.first_entry; e < n.first_entry + n.entry_count; e++)
+    {
+        auto& list = table[std::string(text(entries[e].tag))];
+        list.reserve(entries[e].child_count);
+        for (uint32_t c = entries[e].first_child; c < entries[e].first_child + entries[e].child_count; c++)
+        {
+            list.push_back(symbols[children[c]]);
+        }
+    }
+    return table;
+}
+
+}
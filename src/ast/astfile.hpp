@@ -0,0 +1,108 @@
+/// Copyright 2017 Lucas Saldyt
+#pragma once
+#include "../grammar/grammar.hpp"
+#include <cstdint>
+#include <string_view>
+
+/**
+ * Versioned binary serialization of identified groups (ASTs)
+ * Files can be read in place through a memory map, without parsing, and materialized into an Arena when needed
+ *
+ * Layout, in host byte order, each section starting on an 8 byte boundary:
+ *   ASTHeader
+ *   uint32_t  string_offsets[string_count + 1] Start of each string in the string bytes, plus the end of the last
+ *   char      string_bytes[string_bytes]       Contents of every string, i.e. tags and token text
+ *   ASTNode   nodes[node_count]                Children always come before their parents
+ *   ASTEntry  entries[entry_count]             Tagged child lists of MultiSymbol and group nodes
+ *   uint32_t  children[child_count]            Node indices, referenced by entries
+ *   uint32_t  groups[group_count]              Node index of each top-level group, in order
+ */
+namespace ast
+{
+using namespace grammar;
+
+const char     ast_magic[8] = {'G', 'L', 'O', 'S', 'S', 'A', 'S', 'T'};
+const uint32_t ast_version  = 3;
+
+enum class NodeKind : uint32_t
+{
+    string_literal, // Also punctuators, keywords, operators, etc, which share the class
+    identifier,
+    integer,
+    real,
+    multisymbol,
+    sentinel,
+    group           // Top-level identified group, laid out like a multisymbol
+};
+
+struct ASTHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t string_count;
+    uint32_t string_bytes;
+    uint32_t node_count;
+    uint32_t entry_count;
+    uint32_t child_count;
+    uint32_t group_count;
+    uint32_t reserved;
+};
+
+struct ASTNode
+{
+    NodeKind kind;
+    uint32_t tag;         // String index: tag of a multisymbol or group, or tag of a sentinel
+    uint32_t first_entry;
+    uint32_t entry_count;
+    int32_t  token;       // Index of the token a leaf was built from, or -1 (i.e. for symbols added by transformers)
+    int32_t  line;        // Source line of the symbol, or -1
+    uint64_t value;       // String index of the text, the integer, or the bits of the double
+};
+
+struct ASTEntry
+{
+    uint32_t tag;         // String index of the key, i.e. "val"
+    uint32_t first_child;
+    uint32_t child_count;
+};
+
+void writeAST(const IdentifiedGroups& identified_groups, string filename, const TokenStream* tokens=nullptr);
+
+/**
+ * Read-only view of a binary AST file, mapped into memory
+ * Accessors point straight into the mapping, which lives as long as the ASTFile
+ */
+class ASTFile
+{
+public:
+    ASTFile(string filename);
+    ~ASTFile();
+
+    ASTFile(const ASTFile&) = delete;
+    ASTFile& operator=(const ASTFile&) = delete;
+
+    const ASTHeader& header() const;
+    std::string_view text(uint32_t index) const;
+    const ASTNode&   node(uint32_t index) const;
+    const ASTEntry&  entry(uint32_t index) const;
+    uint32_t         child(uint32_t index) const;
+    uint32_t         group(uint32_t index) const;
+
+    IdentifiedGroups load(Arena& arena, TokenStream* tokens=nullptr) const;
+
+private:
+    string filename;
+    const char*     data = nullptr;
+    size_t          size = 0;
+    const uint32_t* string_offsets = nullptr;
+    const char*     string_bytes   = nullptr;
+    const ASTNode*  nodes          = nullptr;
+    const ASTEntry* entries        = nullptr;
+    const uint32_t* children       = nullptr;
+    const uint32_t* groups         = nullptr;
+
+    void validate();
+    MultiSymbolTable loadTable(const ASTNode& node, const vector<Symbol*>& symbols) const;
+};
+
+}
@@ -0,0 +1,101 @@
+/// Copyright 2017 Lucas Saldyt
+#include "fork.hpp"
+#include "../syntax/symbols/export.hpp"
+
+namespace ast
+{
+
+namespace
+{
+    /**
+     * Copies the MultiSymbols of an AST, which transformers change in place, and shares its leaves, which they never change
+     * Symbols referenced from several places (i.e. after a copy transform) are only copied once
+     */
+    class ASTForker
+    {
+    public:
+        ASTForker(Arena& set_arena, const TokenStream& from, TokenStream& set_to) :
+            arena(set_arena),
+            to(set_to)
+        {
+            err_if(from.size() != to.size(), "Cannot fork an AST onto a token stream of a different length");
+            for (int i = 0; i < from.size(); i++)
+            {
+                if (auto symbol = from.cachedSymbol(i))
+                {
+                    token_positions[symbol] = i;
+                }
+            }
+        }
+
+        Symbol* fork(Symbol* symbol)
+        {
+            auto found = forked.find(symbol);
+            if (found != forked.end())
+            {
+                return found->second;
+            }
+            Symbol* copy = symbol;
+            if (auto multisymbol = dynamic_cast<MultiSymbol*>(symbol))
+            {
+                copy = arena.make<MultiSymbol>(multisymbol->tag, forkTable(multisymbol->table));
+                copy->line = multisymbol->line;
+            }
+            else
+            {
+                auto position = token_positions.find(symbol);
+                if (position != token_positions.end())
+                {
+                    copy = to.symbol(position->second);
+                }
+            }
+            forked[symbol] = copy;
+            return copy;
+        }
+
+        MultiSymbolTable forkTable(const MultiSymbolTable& table)
+        {
+            MultiSymbolTable copy;
+            for (auto kv : table)
+            {
+                auto& list = copy[kv.first];
+                list.reserve(kv.second.size());
+                for (auto symbol : kv.second)
+                {
+                    list.push_back(fork(symbol));
+                }
+            }
+            return copy;
+        }
+
+    private:
+        Arena& arena;
+        TokenStream& to;
+        unordered_map<Symbol*, int>      token_positions;
+        unordered_map<Symbol*, Symbol*> forked;
+    };
+}
+
+/**
+ * Copies an AST, so that it can be transformed to one output language without changing it for the others
+ * Only MultiSymbols are copied. Leaves are shared, except those built from a token of from, which are taken from the
+ * same position of to instead, i.e. with the symbol table of an output language applied
+ * @param identified_groups AST to fork, which is left as it is
+ * @param arena             Arena to construct the copies in
+ * @param from              Stream the AST was identified from
+ * @param to                Stream with the same token types as from, whose symbols the copy uses
+ * @return Copy of the AST
+ */
+IdentifiedGroups forkAST(const IdentifiedGroups& identified_groups, Arena& arena, const TokenStream& from, TokenStream& to)
+{
+    ASTForker forker(arena, from, to);
+    IdentifiedGroups forked;
+    forked.reserve(identified_groups.size());
+    for (const auto& identified_group : identified_groups)
+    {
+        forked.push_back(make_tuple(get<0>(identified_group), forker.forkTable(get<1>(identified_group))));
+    }
+    return forked;
+}
+
+}
@@ -0,0 +1,11 @@
+/// Copyright 2017 Lucas Saldyt
+#pragma once
+#include "../grammar/grammar.hpp"
+
+namespace ast
+{
+using namespace grammar;
+
+IdentifiedGroups forkAST(const IdentifiedGroups& identified_groups, Arena& arena, const TokenStream& from, TokenStream& to);
+
+}
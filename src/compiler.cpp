@@ -1,36 +1,116 @@
 /// Copyright 2017 Lucas Saldyt
 #include "compiler.hpp"
+#include <sys/stat.h>
+#include <cstdio>
 
 /**
- * Demonstration of very high-level compiler usage
+ * Collection of high level functions for compilation
  */
-int main(int argc, char* argv[])
+namespace compiler
 {
-    using namespace compiler;
 
-    vector<string> args;
-    for (int i = 1; i < argc; i++)
+    /**
+     * Reads the value of a numeric option, which has to be a number with nothing after it, and at least minimum
+     * i.e. readNumber<long>("max-steps", "1000000", 0)
+     */
+    template <typename T>
+    T readNumber(const string& flag, const string& value, T minimum)
     {
-        args.push_back(argv[i]);
+        size_t read = 0;
+        T number    = minimum;
+        try
+        {
+            if constexpr (std::is_integral<T>::value)
+            {
+                number = std::stol(value, &read);
+            }
+            else
+            {
+                number = std::stod(value, &read);
+            }
+        }
+        catch (const std::logic_error&) // Not a number (std::invalid_argument), or too large (std::out_of_range)
+        {
+            read = 0;
+        }
+        if (read == 0 or read != value.size() or not (number >= minimum)) // Which also rejects nan
+        {
+            throw named_exception("Invalid value for --" + flag + ": " + value);
+        }
+        return number;
     }
 
-    assert(args.size() > 3);
-
-    int verbosity = std::stoi(args[0]);
-
-    string from = args[1];
-    string to   = args[2];
-    vector<string> files = slice(args, 3);
-
-    compileFiles(files, "input", from, "output", to, verbosity);
-    print("Compilation finished");
-}
+    /**
+     * Removes --flag and --flag=value arguments from the command line, collecting them into options
+     * i.e. --max-steps=1000000 --max-time=10
+     * @param args Command line arguments, left with only positional arguments
+     * @return Options read from the flags
+     */
+    CompilerOptions readOptions(vector<string>& args)
+    {
+        CompilerOptions options;
+        vector<string> positional;
+        for (auto arg : args)
+        {
+            if (arg.size() < 2 or arg.substr(0, 2) != "--")
+            {
+                positional.push_back(arg);
+                continue;
+            }
+            auto split = arg.find("=");
+            string flag  = arg.substr(2, split == string::npos ? string::npos : split - 2);
+            string value = split == string::npos ? "" : arg.substr(split + 1);
 
-/**
- * Collection of high level functions for compilation
- */
-namespace compiler
-{
+            if (flag == "max-steps")
+            {
+                options.max_steps = readNumber<long>(flag, value, 0);
+            }
+            else if (flag == "max-time")
+            {
+                options.max_seconds = readNumber<double>(flag, value, 0.);
+            }
+            else if (flag == "stream")
+            {
+                options.stream = true;
+            }
+            else if (flag == "dump-ast")
+            {
+                options.dump_ast = true;
+            }
+            else if (flag == "from-ast")
+            {
+                options.from_ast = true;
+            }
+            else if (flag == "ast-cache")
+            {
+                options.ast_cache = value.empty() ? ".glossa_cache" : value;
+            }
+            else if (flag == "jobs")
+            {
+                options.jobs = value.empty() ? hardwareJobs() : (int)readNumber<long>(flag, value, 1);
+            }
+            else if (flag == "passes")
+            {
+                options.passes = lex::seperate(value, {make_tuple(",", false)});
+            }
+            else if (flag == "instrument")
+            {
+                options.instrument = value.empty() ? "functions" : value;
+                err_if(options.instrument != "functions" and options.instrument != "loops", "Unknown instrumentation: " + value);
+            }
+            else if (flag == "source-map")
+            {
+                options.source_map = value.empty() ? "json" : value;
+                err_if(options.source_map != "json" and options.source_map != "lines", "Unknown source map: " + value);
+            }
+            else
+            {
+                throw named_exception("Unknown option: " + arg);
+            }
+        }
+        args = positional;
+        return options;
+    }
 
     /**
      * Read in simple symbol conversions from a file
@@ -67,14 +147,24 @@ namespace compiler
 
     /**
      * High level function for loading a code generator for a language
-     * @param language Language for code generator to be loaded for
+     * @param language   Language for code generator to be loaded for
+     * @param instrument "functions" or "loops" to load the constructors that time functions, or functions and loops, or ""
      * @return Generator which can construct source code for the given language
      */
-    Generator loadGenerator(string language)
+    Generator loadGenerator(string language, string instrument)
     {
         print("Loading constructors for " + language);
         auto constructor_files = readFile("languages/" + language + "/constructors/core");
-        auto generator = Generator(constructor_files, "languages/" + language + "/constructors/");
+        vector<string> overlays;
+        if (instrument == "loops")
+        {
+            overlays.push_back("instrument/loops/");
+        }
+        if (not instrument.empty())
+        {
+            overlays.push_back("instrument/");
+        }
+        auto generator = Generator(constructor_files, "languages/" + language + "/constructors/", overlays);
         print("Done");
         return generator;
     }
@@ -93,6 +183,21 @@ namespace compiler
         return transformer;
     }
 
+    /**
+     * Loads the generator, post_transformers and symbol conversions of an output language
+     * @param input_lang   Input language, which symbol conversions are from
+     * @param set_language Output language
+     * @param options      Settings read from command line flags, i.e. --instrument and --source-map
+     */
+    Target::Target(string input_lang, string set_language, const CompilerOptions& options) :
+        language(set_language),
+        generator(loadGenerator(set_language, options.instrument)),
+        post_transformer(loadTransformer(set_language, "post_")),
+        symbol_table(readSymbolTable("languages/symboltables/" + input_lang + set_language))
+    {
+        generator.source_map = options.source_map;
+    }
+
     /**
      * High level function for transpilation
      * Converts source files of one language to source files of another, copying them into a new directory
@@ -100,27 +205,72 @@ namespace compiler
      * @param input_dir   Input directory containing files in input language
      * @param input_lang  String name of input langauge
      * @param output_dir  Output directory that will contain files in output language
-     * @param output_lang String name of output language
+     * @param output_lang String name of output language, or a comma separated list of them (see compileTargets)
      * @param verbosity   Verbosity level of output
+     * @param options     Settings read from command line flags
+     * @return Files that were aborted for going over the step or time budget, which produce no (or partial) output
      */ 
-    void compileFiles(vector<string> filenames, string input_dir, string input_lang, string output_dir, string output_lang, int verbosity)
+    vector<string> compileFiles(vector<string> filenames, string input_dir, string input_lang, string output_dir, string output_lang,
+                                int verbosity, CompilerOptions options)
     {
         auto grammar     = loadGrammar(input_lang);
-        auto generator   = loadGenerator(output_lang);
+        grammar.setBudget(options.max_steps, options.max_seconds);
+        std::deque<Target> targets;
+        unordered_set<string> extensions;
+        for (auto language : lex::seperate(output_lang, {make_tuple(",", false)}))
+        {
+            targets.emplace_back(input_lang, language, options);
+            for (const auto& fc : targets.back().generator.file_constructors)
+            {
+                // Every target writes to output_dir, so two with the same extension would overwrite each other's files
+                err_if(not extensions.insert(get<1>(fc).extension).second, "Output languages write the same kind of file: " + output_lang);
+            }
+        }
+        err_if(targets.empty(), "No output language given");
+        err_if(targets.size() > 1 and (options.from_ast or options.dump_ast or options.stream),
+               "Several output languages can only be compiled together from source, without --from-ast, --dump-ast or --stream");
+        auto& target     = targets.front();
         auto lexmap      = buildLexMap("languages/" + input_lang + "/lex/", grammar.keywords);
         auto pre_transformer  = loadTransformer(input_lang,  "pre_");
-        auto post_transformer = loadTransformer(output_lang, "post_");
-        
-
-        auto symbol_table = readSymbolTable("languages/symboltables/" + input_lang + output_lang);
+        PassManager passes(options.passes);
+        err_if(options.stream and passes.needsWholeFile(), "--stream compiles one group at a time, so it can't run passes over a whole file");
 
         OutputManager logger(verbosity);
 
+        vector<string> aborted;
         for (auto& file : filenames)
         {
             try
             {
-                compile(file, grammar, generator, lexmap, pre_transformer, post_transformer, symbol_table, input_dir, output_dir, logger);
+                if (targets.size() > 1)
+                {
+                    compileTargets(file, grammar, lexmap, pre_transformer, passes, targets, input_dir, output_dir, logger,
+                                   options.ast_cache, options.jobs);
+                }
+                else if (options.from_ast)
+                {
+                    compileFromAST(file, target.generator, target.post_transformer, passes, input_dir, output_dir, logger, options.jobs);
+                }
+                else if (options.dump_ast)
+                {
+                    dumpAST(file, grammar, lexmap, pre_transformer, target.symbol_table, input_dir, output_dir, logger);
+                }
+                else if (options.stream)
+                {
+                    compileStreaming(file, grammar, target.generator, lexmap, pre_transformer, target.post_transformer, passes,
+                                     target.symbol_table, input_dir, output_dir, logger);
+                }
+                else
+                {
+                    compile(file, grammar, target.generator, lexmap, pre_transformer, target.post_transformer, passes, target.symbol_table,
+                            input_dir, output_dir, logger, options.ast_cache, options.jobs);
+                }
+            }
+            catch(const budget_exceeded& e) // Give up on this file only, so one pathological input can't stall the rest
+            {
+                print(string(e.what()));
+                print("Aborted compilation of " + input_dir + "/" + file);
+                aborted.push_back(file);
             }
             catch(...)
             {
@@ -129,6 +279,7 @@ namespace compiler
                 throw;
             }
         }
+        return aborted;
     }
 
     /**
@@ -136,61 +287,388 @@ namespace compiler
      * @param filename         File to be compiled
      * @param grammar          Grammar of input language
      * @param generator        Generator for output language
+     * @param passes           Optimization passes to run between the pre_ and post_transformers
      * @param symbol_table     Dictionary of symbol conversions
      * @param input_directory  String of input directory
      * @param output_directory String name of output directory
      * @param logger           OutputManager class for managing verbose output. Use instead of print() calls
+     * @param ast_cache        Directory to cache universal ASTs in, or "" to not use a cache
+     * @param jobs             Threads to transform and generate top-level groups on
      */
     void compile(string filename, Grammar& grammar, Generator& generator, LexMap& lexmap,
                  Transformer& pre_transformer,
                  Transformer& post_transformer,
+                 PassManager& passes,
                  unordered_map<string, string>& symbol_table, string input_directory, 
-                 string output_directory, OutputManager logger)
+                 string output_directory, OutputManager logger, string ast_cache, int jobs)
     {
         logger.log("Reading file " + filename);
         auto content         = readFile     (input_directory + "/" + filename);
+        logger.log("Initial file");
+        for (auto line : content)
+        {
+            logger.log(line);
+        }
+        logger.log("Lexing terms");
+        auto tokens          = tokenPass    (content, lexmap, {}, logger); 
+        // Symbol conversions depend on the output language, so cached ASTs are keyed by the tokens before conversion
+        uint64_t source_fingerprint = ast_cache.empty() ? 0 : join(tokens, lexmap.newline).fingerprint();
+        substituteSymbols(tokens, symbol_table, logger);
+        logger.log("Joining tokens");
+        auto joined_tokens   = join         (tokens, lexmap.newline);
+        if (ast_cache.empty() and passes.empty())
+        {
+            // The universal AST isn't needed by itself, so each group gets both transformers before the next is transformed
+            auto identified_groups = identifyInitial(joined_tokens, grammar, logger);
+            logger.log("Specialized AST:");
+            vector<Arena> worker_arenas;
+            transformGroups(identified_groups, [&](IdentifiedGroup& identified_group, Arena& arena)
+            {
+                FusedTransformer(pre_transformer, post_transformer)(identified_group, arena);
+            }, joined_tokens.arena, worker_arenas, jobs);
+            showAST(identified_groups, logger);
+            writeOutput(identified_groups, filename, generator, output_directory, logger, jobs);
+        }
+        else
+        {
+            auto identified_groups = ast_cache.empty() ? identifyUniversal(joined_tokens, grammar, pre_transformer, logger) :
+                                     cachedUniversal(joined_tokens, source_fingerprint, grammar, pre_transformer, ast_cache, logger);
+            optimizeUniversal(identified_groups, joined_tokens.arena, passes, logger);
+            generateOutput(identified_groups, filename, joined_tokens.arena, generator, post_transformer, output_directory, logger, jobs);
+        }
+    }
+
+    /**
+     * Compiles a file to several output languages, lexing, identifying and pre_transforming it only once
+     * The universal AST is identified from tokens without symbol conversions, which depend on the output language.
+     * Each target then forks it (see forkAST) onto a stream of its own converted tokens, and applies its post_transformers
+     * to the fork, so targets never see each other's changes. Targets run in parallel, sharing the jobs between them
+     * @param targets Output languages, all writing to output_directory
+     * Other parameters are the same as compile()
+     */
+    void compileTargets(string filename, Grammar& grammar, LexMap& lexmap,
+                        Transformer& pre_transformer,
+                        PassManager& passes,
+                        std::deque<Target>& targets,
+                        string input_directory,
+                        string output_directory, OutputManager logger, string ast_cache, int jobs)
+    {
+        logger.log("Reading file " + filename);
+        auto content = readFile(input_directory + "/" + filename);
         logger.log("Lexing terms");
-        auto tokens          = tokenPass    (content, lexmap, symbol_table, logger); 
-        logger.log("Creating symbols");
-        auto symbolic_tokens = symbolicPass (tokens, logger);
-        logger.log("Joining symbolic tokens");
-        auto joined_tokens   = join         (symbolic_tokens, lexmap.newline);
-        for(auto& jt : joined_tokens)
-        {
-            logger.log("Joined Token: " + jt.type + ", " + jt.sub_type + ", \"" + jt.text + "\" " + std::to_string(jt.line));
+        auto tokens  = tokenPass(content, lexmap, {}, logger);
+        logger.log("Joining tokens");
+        auto joined_tokens     = join(tokens, lexmap.newline);
+        auto identified_groups = ast_cache.empty() ? identifyUniversal(joined_tokens, grammar, pre_transformer, logger) :
+                                 cachedUniversal(joined_tokens, joined_tokens.fingerprint(), grammar, pre_transformer, ast_cache, logger);
+        optimizeUniversal(identified_groups, joined_tokens.arena, passes, logger);
+
+        int target_jobs = std::min(std::max(jobs, 1), (int)targets.size());
+        vector<vector<string>> logs(targets.size());
+        parallelFor(targets.size(), target_jobs, [&](size_t i, int worker)
+        {
+            auto& target        = targets[i];
+            auto target_logger  = target_jobs > 1 ? logger.buffered(logs[i]) : logger;
+            target_logger.log("Forking universal AST for " + target.language);
+            auto target_tokens  = tokens;
+            substituteSymbols(target_tokens, target.symbol_table, target_logger);
+            auto target_stream  = join(target_tokens, lexmap.newline);
+            auto forked_groups  = forkAST(identified_groups, target_stream.arena, joined_tokens, target_stream);
+            generateOutput(forked_groups, filename, target_stream.arena, target.generator, target.post_transformer, output_directory,
+                           target_logger, std::max(jobs / target_jobs, 1));
+        });
+        for (const auto& lines : logs)
+        {
+            logger.replay(lines);
+        }
+    }
+
+    /**
+     * Identifies a file's tokens and applies the input language's pre_transformers, giving its universal AST
+     * @param joined_tokens   Tokens of the file. Symbols of the AST live in its arena
+     * @param grammar         Grammar of input language
+     * @param pre_transformer Transformer from input language to universal AST
+     * @return Universal AST of the file
+     */
+    IdentifiedGroups identifyUniversal(TokenStream& joined_tokens, Grammar& grammar, Transformer& pre_transformer, OutputManager logger)
+    {
+        auto identified_groups = identifyInitial(joined_tokens, grammar, logger);
+        logger.log("Universal AST:");
+        pre_transformer(identified_groups, joined_tokens.arena);
+        showAST(identified_groups, logger);
+        return identified_groups;
+    }
+
+    /**
+     * Identifies a file's tokens, giving its AST in the input language
+     * @param joined_tokens Tokens of the file. Symbols of the AST live in its arena
+     * @param grammar       Grammar of input language
+     * @return AST of the file, before any transformers
+     */
+    IdentifiedGroups identifyInitial(TokenStream& joined_tokens, Grammar& grammar, OutputManager logger)
+    {
+        for (int i = 0; i < joined_tokens.size(); i++)
+        {
+            logger.log("Joined Token: " + interned(joined_tokens.types[i]) + ", " + interned(joined_tokens.sub_types[i]) + ", \"" + joined_tokens.tokenText(i) + "\" " + std::to_string(joined_tokens.lines[i]));
         }
         logger.log("Identifying tokens from grammar:");
+        auto a = getTime();
         auto identified_groups = grammar.identifyGroups(joined_tokens, logger);
+        auto b = getTime();
+        logger.log("Identification step took " + std::to_string((double)(b - a) / 1000000.) + "s");
         logger.log("Initial AST:");
         showAST(identified_groups, logger);
-        logger.log("Universal AST:");
-        pre_transformer(identified_groups);
+        return identified_groups;
+    }
+
+    /**
+     * Universal AST of a file, read from the AST cache when an earlier compile (possibly to another output language)
+     * already identified the same tokens, and added to the cache otherwise
+     * Entries are keyed by the tokens, the grammar and the pre_transformers, so changing any of them misses the cache.
+     * Symbol conversions only change token text, never types, so they don't change the shape of the AST:
+     * the key uses the tokens from before conversion, and leaves are rebuilt from the converted joined_tokens
+     * @param source_fingerprint Fingerprint of the file's tokens before symbol conversion
+     * @param cache_directory    Directory of cached binary ASTs, created if needed
+     * Other parameters are the same as identifyUniversal()
+     */
+    IdentifiedGroups cachedUniversal(TokenStream& joined_tokens, uint64_t source_fingerprint, Grammar& grammar, Transformer& pre_transformer,
+                                     string cache_directory, OutputManager logger)
+    {
+        auto key = contentHash(std::to_string(ast_version), source_fingerprint);
+        key      = contentHash(hexHash(grammar.sourceHash()), key);
+        key      = contentHash(hexHash(pre_transformer.sourceHash()), key);
+        string path = cache_directory + "/" + hexHash(key) + ".gast";
+
+        if (access(path.c_str(), R_OK) == 0)
+        {
+            try
+            {
+                auto identified_groups = ASTFile(path).load(joined_tokens.arena, &joined_tokens);
+                logger.log("Loaded universal AST from " + path);
+                showAST(identified_groups, logger);
+                return identified_groups;
+            }
+            catch (const named_exception& e)
+            {
+                logger.log("Ignoring cached AST " + path + ": " + e.what());
+            }
+        }
+
+        auto identified_groups = identifyUniversal(joined_tokens, grammar, pre_transformer, logger);
+        mkdir(cache_directory.c_str(), 0755);
+        string temporary = path + "." + std::to_string(getpid()); // Renamed into place, so concurrent compiles never read a partial file
+        writeAST(identified_groups, temporary, &joined_tokens);
+        std::rename(temporary.c_str(), path.c_str());
+        logger.log("Cached universal AST in " + path);
+        return identified_groups;
+    }
+
+    /**
+     * Runs optimization passes on a universal AST, before the output language's post_transformers see it
+     * Passes aren't part of the universal AST that --dump-ast and --ast-cache store, so they are run again on every compile
+     * @param identified_groups Universal AST of the file, optimized in place
+     * @param arena             Arena the AST's symbols live in, and new symbols are made in
+     * @param passes            Passes given with --passes
+     */
+    void optimizeUniversal(IdentifiedGroups& identified_groups, Arena& arena, PassManager& passes, OutputManager logger)
+    {
+        if (passes.empty())
+        {
+            return;
+        }
+        logger.log("Optimized AST:");
+        passes(identified_groups, arena, logger);
         showAST(identified_groups, logger);
+    }
+
+    /**
+     * Applies the output language's post_transformers to a universal AST, then generates and writes its files
+     * @param identified_groups Universal AST of the file, transformed in place
+     * @param filename          Name of the file, used for output paths and default file content
+     * @param arena             Arena the AST's symbols live in
+     * @param generator         Generator for output language
+     * @param post_transformer  Transformer from universal AST to output language
+     * @param output_directory  Directory to write generated files to
+     * @param jobs              Threads to transform and generate top-level groups on
+     */
+    void generateOutput(IdentifiedGroups& identified_groups, string filename, Arena& arena, Generator& generator,
+                        Transformer& post_transformer, string output_directory, OutputManager logger, int jobs)
+    {
         logger.log("Specialized AST:");
-        post_transformer(identified_groups);
+        vector<Arena> worker_arenas;
+        transformGroups(identified_groups, [&](IdentifiedGroup& identified_group, Arena& group_arena)
+        {
+            post_transformer(identified_group, group_arena);
+        }, arena, worker_arenas, jobs);
         showAST(identified_groups, logger);
-        logger.log("Compiling identified groups");
-        auto files = compileGroups(identified_groups, filename, generator, logger);
+        writeOutput(identified_groups, filename, generator, output_directory, logger, jobs);
+    }
 
-        logger.log("Initial file");
-        for (auto line : content)
+    /**
+     * Applies a transformation to each top-level group of an AST, on up to jobs threads
+     * Groups are independent, so they can be transformed in any order. Each extra thread makes new symbols in an arena of
+     * its own, which is kept in worker_arenas: it has to outlive the AST
+     * @param transform     Transforms a group in place, making new symbols in the arena it is given
+     * @param arena         Arena of the AST, used by the calling thread
+     * @param worker_arenas Arenas of the other threads, added as needed
+     */
+    void transformGroups(IdentifiedGroups& identified_groups, const function<void(IdentifiedGroup&, Arena&)>& transform,
+                         Arena& arena, vector<Arena>& worker_arenas, int jobs)
+    {
+        jobs = std::min(jobs, (int)identified_groups.size());
+        while ((int)worker_arenas.size() < jobs - 1)
         {
-            logger.log(line);
+            worker_arenas.emplace_back();
+        }
+        parallelFor(identified_groups.size(), jobs, [&](size_t i, int worker)
+        {
+            transform(identified_groups[i], worker == 0 ? arena : worker_arenas[worker - 1]);
+        });
+    }
+
+    /**
+     * Generates and writes the files of an AST that is already in the output language
+     * @param identified_groups Specialized AST of the file
+     * @param filename          Name of the file, used for output paths and default file content
+     * @param generator         Generator for output language
+     * @param output_directory  Directory to write generated files to
+     * @param jobs              Threads to generate top-level groups on
+     */
+    void writeOutput(IdentifiedGroups& identified_groups, string filename, Generator& generator,
+                     string output_directory, OutputManager logger, int jobs)
+    {
+        logger.log("Compiling identified groups");
+        unordered_map<string, Emitter> emitters;
+        unordered_map<string, SourceMap> source_maps;
+        compileGroups(identified_groups, filename, generator,
+            [&](const string& type, const string& path, const vector<string>& body)
+            {
+                if (not contains(emitters, type))
+                {
+                    logger.log("Creating initial " + type + " file");
+                    emitters.emplace(type, Emitter(output_directory + "/" + path));
+                    source_maps.emplace(type, SourceMap(filename, path, generator.source_map));
+                }
+                logger.log("Generated " + type + " code:");
+                emitLines(emitters.at(type), source_maps.at(type), body, logger);
+            }, logger, jobs);
+        for (const auto& kv : source_maps)
+        {
+            kv.second.write(output_directory);
         }
+    }
+
+    /**
+     * Writes the universal AST of a file in the binary AST format, instead of compiling it
+     * The AST is written to output_directory/filename.gast, and can be compiled to any output language with compileFromAST
+     * Parameters are the same as compile()
+     */
+    void dumpAST(string filename, Grammar& grammar, LexMap& lexmap,
+                 Transformer& pre_transformer,
+                 unordered_map<string, string>& symbol_table, string input_directory,
+                 string output_directory, OutputManager logger)
+    {
+        logger.log("Reading file " + filename);
+        auto joined_tokens     = lexFile(input_directory + "/" + filename, lexmap, symbol_table, logger);
+        auto identified_groups = identifyUniversal(joined_tokens, grammar, pre_transformer, logger);
+        logger.log("Writing AST to " + output_directory + "/" + filename + ".gast");
+        writeAST(identified_groups, output_directory + "/" + filename + ".gast", &joined_tokens);
+    }
+
+    /**
+     * Compiles a universal AST written by dumpAST, skipping lexing, identification and pre_transformers
+     * Reads input_directory/filename.gast, and writes the same files compile() would
+     */
+    void compileFromAST(string filename, Generator& generator, Transformer& post_transformer, PassManager& passes,
+                        string input_directory, string output_directory, OutputManager logger, int jobs)
+    {
+        logger.log("Loading AST " + input_directory + "/" + filename + ".gast");
+        Arena arena;
+        auto identified_groups = ASTFile(input_directory + "/" + filename + ".gast").load(arena);
+        showAST(identified_groups, logger);
+        optimizeUniversal(identified_groups, arena, passes, logger);
+        generateOutput(identified_groups, filename, arena, generator, post_transformer, output_directory, logger, jobs);
+    }
 
-        for (auto kv : files)
+    /**
+     * Compiles a file one top-level statement at a time
+     * Each statement is identified, transformed, generated and appended to its output files before the next one is read,
+     * so only the token stream and a single statement's AST are held in memory, and output appears immediately
+     * Parameters are the same as compile()
+     */
+    void compileStreaming(string filename, Grammar& grammar, Generator& generator, LexMap& lexmap,
+                          Transformer& pre_transformer,
+                          Transformer& post_transformer,
+                          PassManager& passes,
+                          unordered_map<string, string>& symbol_table, string input_directory, 
+                          string output_directory, OutputManager logger)
+    {
+        logger.log("Reading file " + filename);
+        auto joined_tokens = lexFile(input_directory + "/" + filename, lexmap, symbol_table, logger);
+
+        unordered_map<string, Emitter> emitters;
+        unordered_map<string, SourceMap> source_maps;
+        int position = 0;
+        while (position < joined_tokens.size())
         {
-            logger.log("Generated " + kv.first + " file:");
-            auto body = get<0>(kv.second);
-            auto path = get<1>(kv.second);
-            for (auto line : body)
+            int start = position;
+            auto mark  = joined_tokens.arena.mark();
+            auto identified_group = grammar.identifyNext(joined_tokens, position, logger);
+            logger.log("Initial AST:");
+            showAST(identified_group, logger);
+            if (passes.empty())
+            {
+                FusedTransformer(pre_transformer, post_transformer)(identified_group, joined_tokens.arena);
+            }
+            else
             {
-                logger.log(line);
+                pre_transformer(identified_group, joined_tokens.arena);
+                passes(identified_group, joined_tokens.arena, logger);
+                post_transformer(identified_group, joined_tokens.arena);
             }
-            writeFile(body, output_directory + "/" + path);
+            logger.log("Specialized AST:");
+            showAST(identified_group, logger);
+
+            string gen_with = emitters.empty() ? filename : "none"; // Default file content comes with the first statement
+            for (auto& fileinfo : compileGroup(identified_group, gen_with, generator, logger))
+            {
+                auto type = get<0>(fileinfo);
+                if (not contains(emitters, type))
+                {
+                    logger.log("Creating initial " + type + " file");
+                    emitters.emplace(type, Emitter(output_directory + "/" + get<1>(fileinfo)));
+                    source_maps.emplace(type, SourceMap(filename, get<1>(fileinfo), generator.source_map));
+                }
+                auto& emitter = emitters.at(type);
+                emitLines(emitter, source_maps.at(type), get<2>(fileinfo), OutputManager(0));
+                emitter.flush();
+            }
+            generator.clearGenerated(); // Memoized code refers to the statement's symbols
+            joined_tokens.releaseSymbols(start, mark);
+            logger.log("Released statement, arena holds " + std::to_string(joined_tokens.arena.used()) + " bytes", 2);
+        }
+        for (const auto& kv : source_maps)
+        {
+            kv.second.write(output_directory);
         }
     }
 
+    /**
+     * Reads, lexes and joins the tokens of a single source file
+     * @param path         File to be read
+     * @param lexmap       Lexing rules of the input language
+     * @param symbol_table Dictionary of symbol conversions
+     * @return Stream of the file's tokens
+     */
+    TokenStream lexFile(string path, LexMap& lexmap, const unordered_map<string, string>& symbol_table, OutputManager logger)
+    {
+        auto content = readFile(path);
+        logger.log("Lexing terms");
+        auto tokens  = tokenPass(content, lexmap, symbol_table, logger);
+        logger.log("Joining tokens");
+        return join(tokens, lexmap.newline);
+    }
+
     /**
      * Converts lines of source code to a list of tokens, provided a grammar
      * @param content Lines of source
@@ -198,9 +676,9 @@ namespace compiler
      * @param symbol_table Dictionary of symbol conversions
      * @return Vector of unsymbolized tokens (annotated terms)
      */
-    std::vector<Tokens> tokenPass(std::vector<std::string> content, LexMap& lexmap, unordered_map<string, string>& symbol_table, OutputManager logger)
+    std::vector<Tokens> tokenPass(std::vector<std::string> content, LexMap& lexmap, const unordered_map<string, string>& symbol_table, OutputManager logger)
     {
-        int line_num = 0;
+        int line_num = 0; // Newlines read so far
         std::vector<Tokens> tokens;
         string unseperated_content;
         for (auto line : content)
@@ -217,32 +695,42 @@ namespace compiler
             }
             else if (in_multiline_string)
             {
-                tokens.push_back(Tokens(1, Token(vector<string>(1, group), "comment", "comment", line_num)));
-                // Count newlines in mulitline comment
-                size_t nPos = group.find("\n", 0); 
-                while (nPos != string::npos)
-                {
-                    line_num++;
-                    nPos = group.find("\n", nPos+1);
-                }
-                line_num++;
+                tokens.push_back(Tokens(1, Token(vector<string>(1, group), "comment", "comment", line_num + 1)));
+                line_num += std::count(group.begin(), group.end(), '\n');
             }
             else
             {
-                auto lines = lex::seperate(group, {make_tuple("\n", false)}, {}, "");
-                for (auto it = lines.begin(); it != lines.end(); it++)
+                // Blank lines make no tokens, but still count, so that line numbers match the source file
+                auto lines = lex::seperate(group, {make_tuple("\n", true)}, {}, "");
+                for (const auto& line : lines)
                 {
-                    line_num++;
-                    auto token_group = lexWith(*it, lexmap, lexmap.string_delimiters, lexmap.comment_delimiter);
+                    if (line == "\n")
+                    {
+                        line_num++;
+                        continue;
+                    }
+                    auto token_group = lexWith(line, lexmap, lexmap.string_delimiters, lexmap.comment_delimiter);
                     for (auto& token : token_group)
                     {
-                        token.line = line_num;
+                        token.line = line_num + 1;
                     }
                     tokens.push_back(token_group);
                 }
             }
         }
 
+        substituteSymbols(tokens, symbol_table, logger);
+        return tokens;
+    }
+
+    /**
+     * Applies simple symbol conversions to the values of lexed tokens
+     * Types and sub types are left alone, so conversions never change how tokens are identified
+     * @param tokens       Tokens to convert in place
+     * @param symbol_table Dictionary of symbol conversions
+     */
+    void substituteSymbols(std::vector<Tokens>& tokens, const unordered_map<string, string>& symbol_table, OutputManager logger)
+    {
         for (auto& token_group : tokens)
         {
             for (auto& token : token_group)
@@ -250,108 +738,162 @@ namespace compiler
                 for (auto& value : token.values)
                 {
                     logger.log("Token Value: " + value, 2);
-                    if (contains(symbol_table, value))
+                    auto found = symbol_table.find(value);
+                    if (found != symbol_table.end())
                     {
-                        value = symbol_table[value];
+                        value = found->second;
                     }
                 }
             }
         }
-        return tokens;
-    }
-
-    /**
-     * Converts a vector of non-symbolic tokens to symbolic ones
-     * @param tokens Non symbolized tokens
-     * @return 2D array of Symbolized tokens
-     */
-    std::vector<vector<SymbolicToken>> symbolicPass(std::vector<Tokens> tokens, OutputManager logger)
-    {
-        std::vector<vector<SymbolicToken>> symbolic_tokens;
-        for (auto token_group : tokens)
-        {
-            symbolic_tokens.push_back(toSymbolic(generatorMap, token_group, logger));
-        }
-        return symbolic_tokens;
     }
 
     /**
-     * Converts a 2D matrix of tokens to a vector
+     * Converts a 2D matrix of tokens to a single stream
+     * Symbols are not created here; the stream constructs them once the parser keeps a token
      * @param token_groups 2D matrix of tokens
      * @param newline option to insert newlines between groups of tokens
-     * @return Vector of symbolic tokens
+     * @return Stream of tokens, stored as parallel arrays
      */
-    vector<SymbolicToken> join(std::vector<vector<SymbolicToken>> token_groups, bool newline)
+    TokenStream join(const std::vector<Tokens>& token_groups, bool newline)
     {
-        auto tokens = vector<SymbolicToken>();
-        for (auto token_group : token_groups)
+        TokenStream tokens;
+        for (const auto& token_group : token_groups)
         {
-            for (auto t : token_group)
+            int line = -1;
+            for (const auto& t : token_group)
             {
                 tokens.push_back(t);
+                line = t.line;
             }
             if (newline)
             {
-                tokens.push_back(SymbolicToken(make_shared<Symbol>(Newline("\n")), "newline", "newline", "\n"));
+                tokens.pushNewline(line);
             }
         }
         return tokens;
     }
 
-    unordered_map<string, tuple<vector<string>, string>> compileGroups(IdentifiedGroups identified_groups,
-                                                                       string filename,
-                                                                       Generator &generator,
-                                                                       OutputManager logger)
+    /**
+     * Generates code for every identified group (top-level statement) of a file, and hands it to emit in source order
+     * Each group is generated with a namespace of its own, so groups are independent: with more than one job they are
+     * generated in parallel, into separate buffers, and emitted in source order afterwards, giving the same files.
+     * With one job, each group is emitted as soon as it is generated, so the code of a whole file is never held at once
+     * @param emit Called with the filetype, path and lines of each group's code, for every filetype
+     * @param jobs Threads to generate groups on. Their log messages are buffered, and printed in order too
+     */
+    void compileGroups(IdentifiedGroups& identified_groups,
+                       string filename,
+                       Generator &generator,
+                       const FileEmitter& emit,
+                       OutputManager logger,
+                       int jobs)
     {
-        unordered_map<string, tuple<vector<string>, string>> files;
-        for (auto identified_group : identified_groups)
+        bool started = false;
+        const auto emitGroup = [&](size_t i, vector<tuple<string, string, vector<string>>>& generated)
         {
-            logger.log("Compiling groups (Identified as " + get<0>(identified_group) + ")");
-            string gen_with = "none";
-            if (files.empty())
+            if (not started and i > 0 and not generated.empty())
             {
-                gen_with = filename;
+                // Default file content comes with the first group that generates anything, which was generated without it
+                generated = compileGroup(identified_groups[i], filename, generator, logger);
             }
-            unordered_set<string> names;
-            logger.log("Generating code for " + get<0>(identified_group));
-            auto a = getTime();
-            auto generated = generator(names, get<1>(identified_group), get<0>(identified_group), gen_with, 1, logger);
-            auto b = getTime();
-            logger.log("Generation step took " + std::to_string((double)(b - a) / 1000000.) + "s");
+            started = started or not generated.empty();
             logger.log("Adding generated code to file content");
-            for (auto fileinfo : generated)
+            for (const auto& fileinfo : generated)
             {
-                string type         = get<0>(fileinfo);
-                string path         = get<1>(fileinfo);
-                vector<string> body = get<2>(fileinfo);
+                emit(get<0>(fileinfo), get<1>(fileinfo), get<2>(fileinfo));
+            }
+            generated.clear();
+        };
 
-                if (contains(files, type))
-                {
-                    logger.log("Adding to " + type + " file");
-                    concat(get<0>(files[type]), body);
-                }
-                else
-                {
-                    logger.log("Creating initial " + type + " file");
-                    files[type] = make_tuple(body, path);
-                }
+        if (jobs <= 1)
+        {
+            for (size_t i = 0; i < identified_groups.size(); i++)
+            {
+                auto generated = compileGroup(identified_groups[i], i == 0 ? filename : "none", generator, logger);
+                emitGroup(i, generated);
             }
+            generator.clearGenerated();
+            return;
+        }
+
+        vector<vector<tuple<string, string, vector<string>>>> generated(identified_groups.size());
+        vector<vector<string>> logs(identified_groups.size());
+        parallelFor(identified_groups.size(), jobs, [&](size_t i, int worker)
+        {
+            generated[i] = compileGroup(identified_groups[i], i == 0 ? filename : "none", generator, logger.buffered(logs[i]));
+        });
+        for (size_t i = 0; i < identified_groups.size(); i++)
+        {
+            logger.replay(logs[i]);
+            emitGroup(i, generated[i]);
+        }
+        generator.clearGenerated();
+    }
+
+    /**
+     * Generates code for a single identified group (top-level statement)
+     * @param identified_group Statement to generate code for
+     * @param gen_with         Filename to create default file content (i.e. includes) with, or "none"
+     * @param generator        Generator for output language
+     * @return Generated files, as (filetype, path, lines)
+     */
+    vector<tuple<string, string, vector<string>>> compileGroup(IdentifiedGroup& identified_group,
+                                                               string gen_with,
+                                                               Generator& generator,
+                                                               OutputManager logger)
+    {
+        logger.log("Compiling groups (Identified as " + get<0>(identified_group) + ")");
+        Names names;
+        logger.log("Generating code for " + get<0>(identified_group));
+        auto a = getTime();
+        auto generated = generator(names, get<1>(identified_group), get<0>(identified_group), gen_with, 1, logger);
+        auto b = getTime();
+        logger.log("Generation step took " + std::to_string((double)(b - a) / 1000000.) + "s");
+        return generated;
+    }
+
+    /**
+     * Appends generated lines to an output file, taking the generator's line markers out of them into its source map
+     * @param emitter    Output file
+     * @param source_map Source map of the file
+     * @param lines      Lines of code, with line markers if the generator was asked for them
+     */
+    void emitLines(Emitter& emitter, SourceMap& source_map, const vector<string>& lines, OutputManager logger)
+    {
+        for (const auto& line : lines)
+        {
+            auto code = source_map.apply(line);
+            logger.log(code);
+            emitter.line(code);
         }
-        return files;
     }
 
     void showAST(const IdentifiedGroups& identified_groups, OutputManager logger)
     {
+        if (not logger.enabled())
+        {
+            return;
+        }
         for (const auto& identified_group : identified_groups)
         {
-            auto ms_table = get<1>(identified_group);
-            for (auto kv : ms_table)
+            showAST(identified_group, logger);
+        }
+    }
+
+    void showAST(const IdentifiedGroup& identified_group, OutputManager logger)
+    {
+        if (not logger.enabled())
+        {
+            return;
+        }
+        const auto& ms_table = get<1>(identified_group);
+        for (const auto& kv : ms_table)
+        {
+            for (const auto& symbol : kv.second)
             {
-                for (auto symbol : kv.second)
-                {
-                    auto abstract = symbol->abstract();
-                    logger.log(abstract);
-                }
+                auto abstract = symbol->abstract();
+                logger.log(abstract);
             }
         }
     }
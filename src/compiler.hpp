@@ -5,11 +5,15 @@
 #include "lex/lex.hpp"
 #include "lex/seperate.hpp"
 #include "lex/lexmap.hpp"
-#include "types/symbolize.hpp"
+#include "types/tokenstream.hpp"
 #include "grammar/grammar.hpp"
 #include "gen/gen.hpp"
 #include "gen/generator.hpp"
 #include "transform/transformer.hpp"
+#include "optimize/passes.hpp"
+#include "ast/astfile.hpp"
+#include "ast/fork.hpp"
+#include <deque>
 
 namespace compiler
 {
@@ -20,29 +24,111 @@ namespace compiler
     using namespace syntax;
     using namespace grammar;
     using namespace transform;
+    using namespace optimize;
+    using namespace ast;
 
-    void compileFiles(vector<string> filenames, string input_dir, string input_lang, string output_dir, string output_lang, int verbosity=1);
+    /// Receives generated code as it is produced: filetype, path of the file, and lines to append to it
+    using FileEmitter = function<void(const string& type, const string& path, const vector<string>& lines)>;
+
+    /**
+     * Settings that change how files are compiled, read from --flags on the command line
+     */
+    struct CompilerOptions
+    {
+        long   max_steps   = 0;  // Parse budget per file, in matcher invocations (0 for no limit)
+        double max_seconds = 0.; // Parse budget per file, in seconds (0 for no limit)
+        bool   stream      = false; // Compile one top-level statement at a time (see compileStreaming)
+        bool   dump_ast    = false; // Write each file's universal AST instead of compiling it (see dumpAST)
+        bool   from_ast    = false; // Compile from universal ASTs written by --dump-ast (see compileFromAST)
+        string ast_cache   = "";    // Directory of cached universal ASTs, shared by compiles to any output language (see cachedUniversal)
+        vector<string> passes;      // Optimization passes to run on the universal AST, in order (see PassManager)
+        int    jobs        = 1;     // Threads that transform and generate the top-level groups of a file at once (see compileGroups)
+        string source_map  = "";    // "json" for a source map next to each generated file, "lines" for #line directives (see SourceMap)
+        string instrument  = "";    // "functions" or "loops" to generate code that times itself, from the constructors in constructors/instrument
+    };
+
+    CompilerOptions readOptions(vector<string>& args);
+
+    /**
+     * Everything that compiles a universal AST to one output language
+     * Generators can't be moved once loaded, so targets are kept in a deque
+     */
+    struct Target
+    {
+        Target(string input_lang, string set_language, const CompilerOptions& options);
+
+        string      language;
+        Generator   generator;
+        Transformer post_transformer;
+        unordered_map<string, string> symbol_table; // Symbol conversions from the input language
+    };
+
+    vector<string> compileFiles(vector<string> filenames, string input_dir, string input_lang, string output_dir, string output_lang,
+                                int verbosity=1, CompilerOptions options=CompilerOptions());
     void compile(string filename, Grammar& grammar, Generator& generator, 
                  LexMap& lexmap,
                  Transformer& pre_transformer,
                  Transformer& post_transformer,
+                 PassManager& passes,
                  unordered_map<string, string>& symbol_table, 
                  string input_directory="", string output_directory="", 
+                 OutputManager logger=OutputManager(1), string ast_cache="", int jobs=1);
+    void compileTargets(string filename, Grammar& grammar, LexMap& lexmap,
+                        Transformer& pre_transformer,
+                        PassManager& passes,
+                        std::deque<Target>& targets,
+                        string input_directory="", string output_directory="",
+                        OutputManager logger=OutputManager(1), string ast_cache="", int jobs=1);
+    void dumpAST(string filename, Grammar& grammar, LexMap& lexmap,
+                 Transformer& pre_transformer,
+                 unordered_map<string, string>& symbol_table,
+                 string input_directory="", string output_directory="",
                  OutputManager logger=OutputManager(1));
+    void compileFromAST(string filename, Generator& generator, Transformer& post_transformer, PassManager& passes,
+                        string input_directory="", string output_directory="",
+                        OutputManager logger=OutputManager(1), int jobs=1);
+    IdentifiedGroups identifyUniversal(TokenStream& joined_tokens, Grammar& grammar, Transformer& pre_transformer, OutputManager logger);
+    IdentifiedGroups identifyInitial(TokenStream& joined_tokens, Grammar& grammar, OutputManager logger);
+    IdentifiedGroups cachedUniversal(TokenStream& joined_tokens, uint64_t source_fingerprint, Grammar& grammar, Transformer& pre_transformer,
+                                     string cache_directory, OutputManager logger);
+    void optimizeUniversal(IdentifiedGroups& identified_groups, Arena& arena, PassManager& passes, OutputManager logger);
+    void transformGroups(IdentifiedGroups& identified_groups, const function<void(IdentifiedGroup&, Arena&)>& transform,
+                         Arena& arena, vector<Arena>& worker_arenas, int jobs=1);
+    void generateOutput(IdentifiedGroups& identified_groups, string filename, Arena& arena, Generator& generator,
+                        Transformer& post_transformer, string output_directory, OutputManager logger, int jobs=1);
+    void writeOutput(IdentifiedGroups& identified_groups, string filename, Generator& generator,
+                     string output_directory, OutputManager logger, int jobs=1);
+    void compileStreaming(string filename, Grammar& grammar, Generator& generator, 
+                          LexMap& lexmap,
+                          Transformer& pre_transformer,
+                          Transformer& post_transformer,
+                          PassManager& passes,
+                          unordered_map<string, string>& symbol_table, 
+                          string input_directory="", string output_directory="", 
+                          OutputManager logger=OutputManager(1));
 
     Grammar     loadGrammar   (string language);
-    Generator   loadGenerator (string language);
+    Generator   loadGenerator (string language, string instrument="");
     Transformer loadTransformer(string language, string prefix="pre_");
 
     unordered_map<string, string> readSymbolTable(string filename);
 
-    vector<Tokens>                tokenPass(vector<string>, LexMap&, unordered_map<string, string>&, OutputManager logger);
-    vector<vector<SymbolicToken>> symbolicPass(vector<Tokens> tokens, OutputManager logger);
-    vector<SymbolicToken>         join(vector<vector<SymbolicToken>>, bool newline=false);
+    vector<Tokens>                tokenPass(vector<string>, LexMap&, const unordered_map<string, string>&, OutputManager logger);
+    void                          substituteSymbols(vector<Tokens>&, const unordered_map<string, string>&, OutputManager logger);
+    TokenStream                   join(const vector<Tokens>&, bool newline=false);
+    TokenStream                   lexFile(string path, LexMap&, const unordered_map<string, string>&, OutputManager logger);
 
-    unordered_map<string, tuple<vector<string>, string>> compileGroups(IdentifiedGroups identified_groups,
-                                                                       string filename,
-                                                                       Generator& generator,
-                                                                       OutputManager logger);
+    void compileGroups(IdentifiedGroups& identified_groups,
+                       string filename,
+                       Generator& generator,
+                       const FileEmitter& emit,
+                       OutputManager logger,
+                       int jobs=1);
+    vector<tuple<string, string, vector<string>>> compileGroup(IdentifiedGroup& identified_group,
+                                                               string gen_with,
+                                                               Generator& generator,
+                                                               OutputManager logger);
+    void emitLines(Emitter& emitter, SourceMap& source_map, const vector<string>& lines, OutputManager logger);
     void showAST(const IdentifiedGroups& identified_groups, OutputManager logger);
+    void showAST(const IdentifiedGroup& identified_group, OutputManager logger);
 }
@@ -5,6 +5,7 @@
 #include "../lex/lexmap.hpp"
 #include "../parse/tokenparsers.hpp"
 #include "../syntax/types.hpp"
+#include "names.hpp"
 
 namespace gen 
 {
@@ -15,17 +16,18 @@ using namespace lex;
 using namespace match;
 using namespace tools;
 
-using ConditionEvaluator = function<bool(unordered_set<string>&, MultiSymbolTable&)>;
+using ConditionEvaluator = function<bool(Names&, MultiSymbolTable&)>;
 template <typename T>
-using ElementConstructor = function<T(unordered_set<string>&, MultiSymbolTable&, string, vector<string>& definitions, int nesting, OutputManager logger)>;
+using ElementConstructor = function<T(Names&, MultiSymbolTable&, string, int nesting, OutputManager logger)>;
 
+/// Builds an element constructor from a line, given the keys of the symbols the constructor defines
 template <typename T>
-using ElementConstructorCreator = function<ElementConstructor<T>(string)>;
+using ElementConstructorCreator = function<ElementConstructor<T>(string, const vector<string>& definitions)>;
 
-const auto defaultBranch = [](unordered_set<string>&, MultiSymbolTable&){return true;};
+const auto defaultBranch = [](Names&, MultiSymbolTable&){return true;};
 const auto inverseBranch = [](ConditionEvaluator c)
 {
-    return [c](unordered_set<string>& names, MultiSymbolTable& ms_table)
+    return [c](Names& names, MultiSymbolTable& ms_table)
     {
         auto condition = c(names, ms_table);
         return not condition;
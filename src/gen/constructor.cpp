@@ -1,14 +1,15 @@
 /// Copyright 2017 Lucas Saldyt
 #include "constructor.hpp"
+#include "template.hpp"
 
 namespace gen
 {
-void addNewLine(vector<string>& generated)
+void addNewLine(vector<string>& generated, int nesting)
 {
-    generated.push_back("\n");
+    generated.push_back(newline(nesting));
 }
-void addNewLine(vector<vector<string>>& generated)
+void addNewLine(vector<vector<string>>& generated, int nesting)
 {}
-void addNewLine(vector<shared_ptr<Symbol>>& generated)
+void addNewLine(vector<Symbol*>& generated, int nesting)
 {}
 }
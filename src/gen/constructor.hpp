@@ -6,9 +6,9 @@
 namespace gen 
 {
 
-void addNewLine(vector<string>& generated);
-void addNewLine(vector<vector<string>>& generated);
-void addNewLine(vector<shared_ptr<Symbol>>& generated);
+void addNewLine(vector<string>& generated, int nesting);
+void addNewLine(vector<vector<string>>& generated, int nesting);
+void addNewLine(vector<Symbol*>& generated, int nesting);
 
 /**
  * Constructs source code for a single syntax element
@@ -17,7 +17,6 @@ template <typename T>
 class Constructor
 {
     Branch<T> main_branch;
-    vector<string> definitions;
 
 public:
     Constructor(){}
@@ -26,12 +25,9 @@ public:
      * Builds a constructor
      * @param set_symbol_storage_generator Function for generating a symbol storage from token groups
      * @param set_main_branch The main branch of the constructor
-     * @param set_definitions Defined names
      */
-    Constructor(Branch<T> set_main_branch, 
-                vector<string> set_definitions) : 
-        main_branch(set_main_branch),
-        definitions(set_definitions)
+    Constructor(Branch<T> set_main_branch) : 
+        main_branch(set_main_branch)
     {
     }
 
@@ -44,8 +40,8 @@ public:
      * @param nesting Level of indentation
      * @return Lines of source code
      */
-    vector<T> evaluateBranch(Branch<T> branch, 
-                             unordered_set<string>& names, 
+    vector<T> evaluateBranch(const Branch<T>& branch, 
+                             Names& names, 
                              MultiSymbolTable& ms_table,
                              string filetype, 
                              int nesting=0, 
@@ -58,14 +54,14 @@ public:
         {
             for (auto it = branch.line_constructors.begin(); it != branch.line_constructors.end(); it++)
             {
-                auto line_constructor = *it;
-                generated.push_back(line_constructor(names, ms_table, filetype, definitions, nesting, logger));
+                const auto& line_constructor = *it;
+                generated.push_back(line_constructor(names, ms_table, filetype, nesting, logger));
                 if (it + 1 != branch.line_constructors.end())
                 {
-                    addNewLine(generated);
+                    addNewLine(generated, nesting);
                 }
             }
-            for (auto nested_branch : branch.nested_branches)
+            for (const auto& nested_branch : branch.nested_branches)
             {
                 concat(generated, evaluateBranch(nested_branch, names, ms_table, filetype, nesting, logger));
             }  
@@ -76,12 +72,12 @@ public:
     /**
      * Constructs a syntax element from symbol_groups
      * @param names Namespace
-     * @param symbol_groups 2D array of shared_ptr<Symbol>s
+     * @param symbol_groups 2D array of Symbol pointers
      * @param filetype String description of filetype
      * @param nesting Indentation level
      * @return Lines of source code representing the given syntax element
      */
-    vector<T> operator()(unordered_set<string>& names, 
+    vector<T> operator()(Names& names, 
                          MultiSymbolTable&      ms_table, 
                          string filetype, 
                          int nesting=0, 
@@ -12,11 +12,31 @@ namespace gen
      */
     string format(const string& inner, const string& formatter)
     {
-        string representation(formatter);
-        replaceAll(representation, "@", inner);
+        string representation;
+        formatInto(representation, inner, formatter);
         return representation;
     }
 
+    /**
+     * Appends a formatted string to code that is being generated, in one pass over the formatter
+     * @param destination Code to append to
+     * @param inner Replacement string
+     * @param formatter String containing @ symbols
+     */
+    void formatInto(string& destination, const string& inner, const string& formatter)
+    {
+        size_t start = 0;
+        size_t found = formatter.find('@');
+        while (found != string::npos)
+        {
+            destination.append(formatter, start, found - start);
+            destination += inner;
+            start = found + 1;
+            found = formatter.find('@', start);
+        }
+        destination.append(formatter, start, string::npos);
+    }
+
     /**
      * Helper function for generating delimited source code from symbols
      * @param generator Generator for a particular language
@@ -26,15 +46,24 @@ namespace gen
      * @param sep       String to seperate generated code with
      * @param formatter String to format each element with
      * @param nesting   Indentation level
+     * @param mark_lines Whether to mark the source line of each symbol before its code (see SourceMap)
      * @return Formatted string representing delimited constructed syntax elements
      */
-    string sepWith(Generator& generator, const vector<shared_ptr<Symbol>>& symbols, unordered_set<string>& names, string filetype, string sep, string formatter, int nesting)
+    string sepWith(Generator& generator, const SymbolList& symbols, Names& names, string filetype, string sep, string formatter, int nesting, bool mark_lines)
     {
         string line = "";
         for (int i = 0; i < symbols.size(); i++)
         { 
             string inner_representation = symbols[i]->representation(generator, names, filetype, nesting);
-            line += format(inner_representation, formatter);
+            if (dynamic_cast<MultiSymbol*>(symbols[i]) == nullptr) // Leaves may carry keywords, i.e. added by transformers
+            {
+                inner_representation = indentLines(substituteKeywords(inner_representation), nesting);
+            }
+            if (mark_lines and symbols[i]->line >= 0)
+            {
+                line += lineMarker(symbols[i]->line);
+            }
+            formatInto(line, inner_representation, formatter);
 
             if (i+1 != symbols.size()) //If not on last iteration
             {
@@ -18,8 +18,9 @@ namespace gen
 using namespace syntax;
 using namespace tools;
 
-tuple<vector<string>, vector<string>> generateFiles(string filename, vector<shared_ptr<Symbol>>& symbols, Generator& generator);
+tuple<vector<string>, vector<string>> generateFiles(string filename, SymbolList& symbols, Generator& generator);
 
-string sepWith(Generator& generator, const vector<shared_ptr<Symbol>>&, unordered_set<string>& names, string filetype, string sep=" ", string formatter="@", int nesting=0);
+string sepWith(Generator& generator, const SymbolList&, Names& names, string filetype, string sep=" ", string formatter="@", int nesting=0, bool mark_lines=false);
 string format(const string& inner, const string& formatter);
+void formatInto(string& destination, const string& inner, const string& formatter);
 }
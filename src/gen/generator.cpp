@@ -1,29 +1,94 @@
 /// Copyright 2017 Lucas Saldyt
 #include "generator.hpp"
 #include "../syntax/symbols/export.hpp"
+#include <mutex>
 
 namespace gen 
 {
 
+namespace
+{
+    /// Impure symbols generated on this thread, see Generator::representation
+    /// A subtree is generated on one thread, so symbols generated in parallel by other threads can't make it look impure
+    thread_local int impure_generations = 0;
+}
+
+/**
+ * Checks if a constructor adds to the namespace (defines) or branches on it (defined), so its code depends on more than its symbols
+ * @param content Lines of a constructor file
+ * @param file_constructors File types, whose lines end the definitions
+ * @return true if the constructor uses the namespace
+ */
+bool usesNames(const vector<string>& content, const vector<tuple<string, FileConstructor>>& file_constructors)
+{
+    bool defining = false;
+    for (const auto& line : content)
+    {
+        auto terms = lex::seperate(line, {make_tuple(" ", false)});
+        if (terms.empty())
+        {
+            continue;
+        }
+        if (terms[0] == "defines")
+        {
+            defining = true;
+        }
+        else if (std::any_of(file_constructors.begin(), file_constructors.end(), [&](const auto& fc){ return get<0>(fc) == line; }))
+        {
+            defining = false;
+        }
+        else if (defining or (terms[0] == "branch" and contains(terms, "defined"s)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Whether a constructor writes the source line of its symbol, so identical symbols on other lines don't share its code
+bool usesSourceLine(const vector<string>& content)
+{
+    return std::any_of(content.begin(), content.end(), [](const string& line){ return contains(line, "`line`"s); });
+}
+
 /**
  * Constructs a generator
  * @param filenames Construction files
  * @param directory Directory that construction files reside in
+ * @param overlays  Subdirectories of directory with replacements for some construction files, each listed in its own core file.
+ *                  The first overlay to list a file wins, i.e. {"instrument/loops/", "instrument/"}
  */
-Generator::Generator(vector<string> filenames, string directory)
+Generator::Generator(vector<string> filenames, string directory, vector<string> overlays)
 {
     readStructureFile(directory + "file");
+    vector<vector<string>> overlaid;
+    for (const auto& overlay : overlays)
+    {
+        overlaid.push_back(readFile(directory + overlay + "core"));
+        err_if(overlaid.back().empty(), "No constructors in " + directory + overlay);
+    }
     for (auto filename : filenames)
     {
+        auto path = directory + filename;
+        for (size_t i = 0; i < overlays.size(); i++)
+        {
+            if (contains(overlaid[i], filename))
+            {
+                path = directory + overlays[i] + filename;
+                break;
+            }
+        }
         print("Loading constructor " + filename);
-        construction_map[filename] = readConstructor(directory + filename);
+        auto content = readFile(path);
+        construction_map[filename] = readConstructor(content);
+        if (usesNames(content, file_constructors) or usesSourceLine(content))
+        {
+            impure_constructors.insert(filename);
+        }
     }
-    ec_creator = [this](string s){ return this->generateElementConstructor(s);}; 
+    ec_creator = [this](string s, const vector<string>& definitions){ return this->generateElementConstructor(s, definitions);}; 
     vector<string> default_body = {"branch contains val", "$val$", "end"};
-    default_constructor = Constructor<string>(
-                                generateBranch<string>(default_body, ec_creator),
-                                {}
-                                );
+    default_constructor = Constructor<string>(generateBranch<string>(default_body, ec_creator, {}));
 }
 
 /**
@@ -68,13 +133,12 @@ void Generator::readStructureFile(string filename)
 
 /**
  * Builds a constructor for a particular syntax element
- * @param filename File containing the constructor description
+ * @param content Lines of the constructor file
  * @return vector of annotated file constructors (i.e. {("header", Constructor), ("source", Constructor)}
  */
-vector<tuple<string, Constructor<string>>> Generator::readConstructor(string filename)
+vector<tuple<string, Constructor<string>>> Generator::readConstructor(const vector<string>& content)
 {
-    auto content    = readFile(filename);
-    ElementConstructorCreator<string> ec_creator = [this](string s){ return this->generateElementConstructor(s);}; 
+    ElementConstructorCreator<string> ec_creator = [this](string s, const vector<string>& definitions){ return this->generateElementConstructor(s, definitions);}; 
     return generateConstructor<string>(content, file_constructors, ec_creator);
 }
 
@@ -88,225 +152,266 @@ vector<tuple<string, Constructor<string>>> Generator::readConstructor(string fil
  * @param nesting Indentation level
  * @return Vector of files 
  */
-vector<tuple<string, string, vector<string>>> Generator::operator()(unordered_set<string>& names, 
-                                                                    MultiSymbolTable&      ms_table, 
-                                                                    string                 symbol_type, 
-                                                                    string                 filename,
-                                                                    int                    nesting,
-                                                                    OutputManager          logger)
+vector<tuple<string, string, vector<string>>> Generator::operator()(Names&            names, 
+                                                                    MultiSymbolTable& ms_table, 
+                                                                    string            symbol_type, 
+                                                                    string            filename,
+                                                                    int               nesting,
+                                                                    OutputManager     logger)
 {
     logger.log("Running generator for " + symbol_type, 2);
     vector<tuple<string, string, vector<string>>> files;
-    unordered_set<string> added_names;
-    vector<tuple<string, Constructor<string>>> constructors;
-    if (not contains(construction_map, symbol_type))
+    Names added_names;
+    for (const auto& fc : file_constructors)
     {
-        err_if(ms_table.size() != 1, "\"" + symbol_type + "\" is not in the construction map and cannot be built using a default constructor (id)");
-        for (auto fc : file_constructors)
+        auto type = get<0>(fc);
+        Names local_names(&names); // Each filetype sees only the names defined before this symbol
+
+        vector<string> default_content;
+        if (filename != "none")
         {
-            auto filetype = get<0>(fc);
-            constructors.push_back(make_tuple(filetype, 
-                        default_constructor
-                            ));
+            for (auto line : get<1>(fc).default_content)
+            {
+                default_content.push_back(format(filename, line));
+            }
         }
+        auto constructed = generate(local_names, ms_table, symbol_type, type, nesting, logger);
+        markLine(constructed, firstLine(ms_table));
+        concat(default_content, constructed);
+        added_names.merge(local_names);
+        files.push_back(make_tuple(type, filename + get<1>(fc).extension, default_content));
     }
-    else
+    names.merge(added_names);
+    return files;
+}
+
+/**
+ * Marks the source line of a top-level symbol at the start of its code, when generating a source map
+ * @param constructed Lines of code for the symbol
+ * @param line Source line of the symbol, or -1
+ */
+void Generator::markLine(vector<string>& constructed, int line)
+{
+    if (source_map.empty() or line < 0)
     {
-        constructors = construction_map[symbol_type];
+        return;
     }
-    for (auto t : constructors)
+    for (auto& code : constructed)
     {
-        auto type        = get<0>(t);
-        auto constructor = get<1>(t);
-        unordered_set<string> local_names(names);
+        auto start = code.find_first_not_of(" \t\n");
+        if (start != string::npos)
+        {
+            code.insert(start, lineMarker(line));
+            return;
+        }
+    }
+}
 
-        string extension;
-        vector<string> default_content;
-        for (auto fc : file_constructors)
+/**
+ * Generates the code for a symbol in a single filetype, running only that filetype's constructor
+ * Nested symbols are generated in the filetype of their parent, so generating each of them for every filetype
+ * (as operator() does for top-level symbols) would multiply the work by the number of filetypes at every level
+ * @param names Namespace, which the constructor adds its definitions to
+ * @param symbol_type Type of the symbol, i.e. its tag
+ * @param filetype The target filetype to generate for
+ * @param nesting Indentation level
+ * @return Lines of code
+ */
+vector<string> Generator::generate(Names&                 names,
+                                   MultiSymbolTable&      ms_table,
+                                   const string&          symbol_type,
+                                   const string&          filetype,
+                                   int                    nesting,
+                                   OutputManager          logger)
+{
+    auto found = construction_map.find(symbol_type);
+    if (found == construction_map.end())
+    {
+        err_if(ms_table.size() != 1, "\"" + symbol_type + "\" is not in the construction map and cannot be built using a default constructor (id)");
+        return default_constructor(names, ms_table, filetype, nesting, logger);
+    }
+    for (auto& t : found->second)
+    {
+        if (get<0>(t) == filetype)
         {
-            if (get<0>(fc) == type)
-            {
-                if (filename != "none")
-                {
-                    for (auto line : get<1>(fc).default_content)
-                    {
-                        default_content.push_back(format(filename, line));
-                    }
-                }
-                extension = get<1>(fc).extension;
-                break;
-            }
-        } 
-        auto constructed = constructor(local_names, ms_table, type, nesting, logger);
-        concat(default_content, constructed);
-        added_names.insert(local_names.begin(), local_names.end());
-        files.push_back(make_tuple(type, filename + extension, default_content));
+            return get<1>(t)(names, ms_table, filetype, nesting, logger);
+        }
     }
-    names.insert(added_names.begin(), added_names.end());
-    return files;
+    return {};
 }
 
 /**
- * Builds a line constructor from a line in a constructor file
- * @param line Line in constructor file
- * @return ElementConstructor<string>, see TypeDef
+ * Generates the code for a MultiSymbol in one filetype
+ * Symbols that don't use the namespace, including their children, are pure: their code is memoized by structure hash,
+ * so repeated subtrees (i.e. the same identifier or len(array) all over a file) are only generated once per filetype.
+ * Code is generated already indented for its nesting, so code spanning lines is memoized per nesting, and code that
+ * fits on one line (which nesting can't change) is shared by every nesting. Code with line markers is also memoized
+ * by source line. A hit is only used if its symbol has the same structure, so colliding hashes are regenerated
+ * @param symbol MultiSymbol to generate code for
+ * @param names Namespace
+ * @param filetype The target filetype to generate for
+ * @param nesting Indentation level
+ * @return Code for symbol, without empty lines
  */
-ElementConstructor<string> Generator::generateElementConstructor(string line)
+string Generator::representation(MultiSymbol& symbol, Names& names, string filetype, int nesting)
 {
-    auto terms = lex::seperate(line, {make_tuple("`", true)}, {});
-    return [terms, line, this](unordered_set<string>& names, 
-                               MultiSymbolTable& ms_table, 
-                               string filetype, 
-                               vector<string>& definitions, 
-                               int nesting, 
-                               OutputManager logger)
+    int line        = source_map.empty() ? -1 : symbol.line;
+    auto line_key   = contentHash(filetype, symbol.hash());
+    auto nested_key = contentHash(filetype, mixHash(nesting, symbol.hash()));
+    if (not source_map.empty())
+    {
+        nested_key = mixHash(symbol.line, nested_key);
+    }
+    const auto matches = [&](const GeneratedSymbol& generated, int generated_nesting, int generated_line)
+    {
+        return generated.nesting == generated_nesting and generated.line == generated_line and
+               generated.filetype == filetype and generated.symbol->sameStructure(symbol);
+    };
     {
-        string representation;
-        if (terms.size() == 1)
+        std::shared_lock<std::shared_mutex> lock(*generated_mutex);
+        auto found = generated_symbols.find(line_key);
+        if (found != generated_symbols.end() and matches(found->second, 0, -1))
         {
-            auto to_format = lex::seperate(line, {make_tuple("$", true)}, {}); // Symbols to be replaced are surrounded in "$"
-            bool formatting_symbol = false;
-            for (auto t : to_format)
-            {
-                if (t == "$")
-                {
-                    formatting_symbol = !formatting_symbol;
-                }
-                else
-                {
-                    if (formatting_symbol)
-                    {
-                        representation += formatSymbol(t, names, ms_table, filetype, definitions);
-                    }
-                    else
-                    {
-                        representation += t; // Evenly numbered terms do not need to be formatted
-                    }
-                }
-            }
+            return found->second.code;
         }
-        else
+        found = generated_symbols.find(nested_key);
+        if (found != generated_symbols.end() and matches(found->second, nesting, line))
         {
-            bool special_formatting = false;
-            for (auto t : terms)
-            {
-                if (t == "`")
-                {
-                    special_formatting = !special_formatting;
-                }
-                else if (special_formatting)
-                {
-                    auto slc = generateSpecialElementConstructor(t);
-                    representation += slc(names, ms_table, filetype, definitions, nesting, logger);
-                }
-                else
-                {
-                    auto lc = generateElementConstructor(t);
-                    representation += lc(names, ms_table, filetype, definitions, nesting, logger);
-                }
-            }
+            return found->second.code;
         }
-        replaceAll(representation, "EMPTY",   "");
-        replaceAll(representation, "SPACE",   " ");
-        replaceAll(representation, "NEWLINE", "\n");
-        replaceAll(representation, "INDENT",  repeatString("    ", nesting));
-        return representation;
+    }
+
+    // Children that touch the namespace count as impure generations too, so the whole subtree is checked
+    int impure_before = impure_generations;
+    if (contains(impure_constructors, symbol.tag))
+    {
+        impure_generations++;
+    }
+    string representation;
+    for (const auto& line : generate(names, symbol.table, symbol.tag, filetype, nesting))
+    {
+        representation += line;
+    }
+    if (impure_generations == impure_before)
+    {
+        std::unique_lock<std::shared_mutex> lock(*generated_mutex);
+        bool one_line = representation.find('\n') == string::npos and representation.find(line_marker_begin) == string::npos;
+        generated_symbols[one_line ? line_key : nested_key] =
+            GeneratedSymbol{&symbol, filetype, one_line ? 0 : nesting, one_line ? -1 : line, representation};
+    }
+    return representation;
+}
+
+/**
+ * Forgets the memoized code of every symbol, which has to happen before the arena the symbols are in is released or
+ * reused: after each file, and after each statement when streaming. This also keeps the memo from growing over a run
+ */
+void Generator::clearGenerated()
+{
+    std::unique_lock<std::shared_mutex> lock(*generated_mutex);
+    generated_symbols.clear();
+}
+
+/**
+ * Builds a line constructor from a line in a constructor file
+ * The line is compiled once here, so generating it only runs its operations
+ * @param line Line in constructor file
+ * @param definitions Keys of the symbols whose names the constructor defines
+ * @return ElementConstructor<string>, see TypeDef
+ */
+ElementConstructor<string> Generator::generateElementConstructor(string line, const vector<string>& definitions)
+{
+    auto ops = compileTemplate(line, definitions);
+    return [ops, this](Names& names, 
+                       MultiSymbolTable& ms_table, 
+                       string filetype, 
+                       int nesting, 
+                       OutputManager logger)
+    {
+        return construct(ops, names, ms_table, filetype, nesting);
     };
 }
 
 /**
- * Builds a backtick seperated line constructor
- * @param line content inside of backticks
- * @return ElementConstructor<string>, see typedef
+ * Runs the operations of a compiled constructor line
+ * @param ops Operations, see compileTemplate
+ * @param names Namespace
+ * @param ms_table Symbols of the element being generated
+ * @param filetype The target filetype to generate for
+ * @param nesting Indentation level
+ * @return Generated code for the line
  */
-ElementConstructor<string> Generator::generateSpecialElementConstructor(string line)
+string Generator::construct(const vector<TemplateOp>& ops, Names& names, MultiSymbolTable& ms_table, const string& filetype, int nesting)
 {
-    auto terms = lex::seperate(line, {make_tuple(" ", false)});
-    return [terms, line, this](unordered_set<string>& names, 
-                               MultiSymbolTable& ms_table, 
-                               string filetype, 
-                               vector<string>& definitions, 
-                               int nesting, 
-                               OutputManager logger)
+    string representation;
+    for (const auto& op : ops)
     {
-        string representation = "";
-        if (not terms.empty())
+        switch (op.opcode)
         {
-            auto keyword = terms[0];
-            if (keyword == "sep")
-            {
-                assert(terms.size() == 3 or terms.size() == 4 or terms.size() == 5);
-                err_if(not contains(ms_table, terms[2]), terms[2] + " is not in the multi symbol table");
-                auto symbols = ms_table[terms[2]];
-                string formatter = "@";
-                if (terms.size() > 3)
-                {
-                    formatter = terms[3];
-                }
-                representation += sepWith(*this, symbols, names, filetype, terms[1], formatter, nesting);
-            }
-            else if (keyword == "block") // e.g. block body @;
+            case TemplateOpcode::text:
+                representation += op.text;
+                break;
+            case TemplateOpcode::newline:
+                representation += newline(nesting);
+                break;
+            case TemplateOpcode::symbol:
+                representation += formatSymbol(op, names, ms_table, filetype, nesting);
+                break;
+            case TemplateOpcode::sep:
             {
-                assert(terms.size() == 2 or terms.size() == 3);
-                //print(terms[1]);
-                assert(contains(ms_table, terms[1]));
-                auto symbols = ms_table[terms[1]];
-                string formatter = "@";
-                if (terms.size() > 2)
-                {
-                    formatter = terms[2];
-                }
-                auto block = sepWith(*this, symbols, names, filetype, "\n", formatter, nesting + 1); // The only place where nesting increases
-                auto block_terms = lex::seperate(block, {make_tuple("\n", true)}, {});
-                representation += repeatString("    ", nesting);
-                for (auto term : block_terms)
-                {
-                    if (term == "\n")
-                    {
-                        representation += term + repeatString("    ", nesting);
-                    }
-                    else
-                    {
-                        representation += term;
-                    }
-                }
+                auto symbols = ms_table.find(op.tag);
+                err_if(symbols == nullptr, op.key + " is not in the multi symbol table");
+                auto sep       = op.multiline ? indentLines(op.text, nesting) : op.text;
+                auto formatter = op.multiline ? indentLines(op.formatter, nesting) : op.formatter;
+                representation += sepWith(*this, *symbols, names, filetype, sep, formatter, nesting);
+                break;
             }
-            else
+            case TemplateOpcode::block:
             {
-                throw named_exception("Unknown special line constructor: " + line);
+                // The only place where nesting increases: the symbols are generated already indented, one per line
+                auto symbols = ms_table.find(op.tag);
+                assert(symbols != nullptr);
+                auto formatter = op.multiline ? indentLines(op.formatter, nesting + 1) : op.formatter;
+                representation += "    ";
+                representation += sepWith(*this, *symbols, names, filetype, newline(nesting + 1), formatter, nesting + 1, not source_map.empty());
+                break;
             }
+            case TemplateOpcode::line:
+                representation += std::to_string(std::max(firstLine(ms_table), 0));
+                break;
+            case TemplateOpcode::invalid:
+                throw named_exception("Unknown special line constructor: " + op.text);
         }
-        return representation;
-    };
+    }
+    return representation;
 }
 
 /**
  * Function for retrieving/building a symbol from storage
- * @param s The user-defined name for the symbol
+ * @param op Symbol slot of a constructor line, naming the symbol and whether it is a definition
  * @param names Namespace
- * @param storage Dual dictionaries containing symbol types
+ * @param ms_table Symbols of the element being generated
  * @param filetype The target filetype to generate for
- * @param definitions Defined names
+ * @param nesting Indentation level
  * @return Formatted string representing a stored symbol
  */
-string Generator::formatSymbol (string s, unordered_set<string>& names, MultiSymbolTable& ms_table, string filetype, vector<string>& definitions)
+string Generator::formatSymbol (const TemplateOp& op, Names& names, MultiSymbolTable& ms_table, const string& filetype, int nesting)
 {
-    err_if(not contains(ms_table, s), s + " is not in the symbol table");
-    auto ms_group = ms_table[s];         
-    assert(ms_group.size() == 1);
+    auto ms_group = ms_table.find(op.tag);
+    err_if(ms_group == nullptr, op.key + " is not in the symbol table");
+    assert(ms_group->size() == 1);
 
-    auto symbol         = ms_group[0];
-    auto representation = symbol->representation(*this, names, filetype);
-    auto new_name       = symbol->name();
-    if (new_name != "none" and contains(definitions, s)) 
+    auto symbol         = (*ms_group)[0];
+    auto representation = symbol->representation(*this, names, filetype, nesting);
+    if (dynamic_cast<MultiSymbol*>(symbol) == nullptr) // Leaves may carry keywords, i.e. added by transformers
     {
-        if (contains(names, new_name))
-        {
-            //print("Name " + new_name + " is already defined");
-        }
-        else
+        representation = indentLines(substituteKeywords(representation), nesting);
+    }
+    if (op.defines)
+    {
+        auto new_name = symbol->name();
+        if (new_name != "none")
         {
-            //print("Adding name: " + new_name);
             names.insert(new_name);
         }
     }
@@ -3,11 +3,31 @@
 #include "constructor.hpp"
 #include "fileconstructor.hpp"
 #include "read.hpp"
+#include "template.hpp"
+#include "sourcemap.hpp"
+#include <shared_mutex>
+
+namespace syntax
+{
+struct MultiSymbol;
+}
 
 namespace gen 
 {
 
-vector<shared_ptr<Symbol>> fromTokens(vector<SymbolicToken>);
+vector<Symbol*> fromTokens(vector<SymbolicToken>);
+
+/**
+ * Memoized code of a pure symbol, and the symbol and context it was generated from, which a hit has to match
+ */
+struct GeneratedSymbol
+{
+    MultiSymbol* symbol;
+    string filetype;
+    int nesting; // 0 for code on a single line, which is the same at any nesting
+    int line;    // Source line of the symbol when its code has line markers, otherwise -1
+    string code;
+};
 
 /**
  * Class for generating source code from AST in a particular language
@@ -17,26 +37,44 @@ class Generator
 
 public:
 
-    Generator(vector<string> grammar_files, string directory);
+    Generator(vector<string> grammar_files, string directory, vector<string> overlays={});
     vector<tuple<string, string, vector<string>>> operator()
-        (unordered_set<string>& names, 
+        (Names& names, 
          MultiSymbolTable&, 
          string symbol_type, 
          string filename="none", 
          int nesting=1, 
          OutputManager logger=OutputManager(1));
+    vector<string> generate(Names& names,
+                            MultiSymbolTable& ms_table,
+                            const string& symbol_type,
+                            const string& filetype,
+                            int nesting=1,
+                            OutputManager logger=OutputManager(1));
+    string representation(MultiSymbol& symbol, Names& names, string filetype, int nesting=1);
+    void clearGenerated();
 
     vector<tuple<string, FileConstructor>> file_constructors;
+    string source_map = ""; // "json" or "lines" to mark where code for each statement starts (see SourceMap), or ""
 private:
     unordered_map<string, vector<tuple<string, Constructor<string>>>> construction_map;
+    unordered_set<string> impure_constructors; // Symbol types whose code adds to or depends on the namespace
+    unordered_map<uint64_t, GeneratedSymbol> generated_symbols; // Code of pure symbols, by structure hash, filetype and nesting
+    std::unique_ptr<std::shared_mutex> generated_mutex = std::make_unique<std::shared_mutex>(); // Groups may be generated in parallel
+
+    string formatSymbol (const TemplateOp& op, Names& names, MultiSymbolTable& ms_table, const string& filetype, int nesting);
 
-    string formatSymbol (string s, unordered_set<string>& names, MultiSymbolTable& ms_table, string filetype, vector<string>& definitions);
+    void markLine(vector<string>& constructed, int line);
 
-    vector<tuple<string, Constructor<string>>> readConstructor(string filename);
+    vector<tuple<string, Constructor<string>>> readConstructor(const vector<string>& content);
     void readStructureFile(string filename);
 
-    ElementConstructor<string> generateElementConstructor(string line);
-    ElementConstructor<string> generateSpecialElementConstructor(string line);
+    ElementConstructor<string> generateElementConstructor(string line, const vector<string>& definitions);
+    string construct(const vector<TemplateOp>& ops,
+                     Names& names,
+                     MultiSymbolTable& ms_table,
+                     const string& filetype,
+                     int nesting);
 
     ElementConstructorCreator<string> ec_creator;
     Constructor<string> default_constructor;
@@ -0,0 +1,47 @@
+/// Copyright 2017 Lucas Saldyt
+#include "names.hpp"
+
+namespace gen
+{
+
+/**
+ * Creates an empty frame
+ * @param set_parent Frame this one is pushed on, whose names stay visible, or nullptr for a new namespace
+ */
+Names::Names(const Names* set_parent) : parent(set_parent)
+{
+}
+
+/**
+ * Checks if a name is defined in this frame or any frame below it
+ */
+bool Names::contains(const string& name) const
+{
+    auto id = intern(name);
+    for (auto frame = this; frame != nullptr; frame = frame->parent)
+    {
+        if (frame->defined.find(id) != frame->defined.end())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Defines a name in this frame
+ */
+void Names::insert(const string& name)
+{
+    defined.insert(intern(name));
+}
+
+/**
+ * Keeps the definitions of a frame that was pushed on this one, or on the same parent
+ */
+void Names::merge(const Names& frame)
+{
+    defined.insert(frame.defined.begin(), frame.defined.end());
+}
+
+}
@@ -0,0 +1,32 @@
+/// Copyright 2017 Lucas Saldyt
+#pragma once
+#include "../tools/tools.hpp"
+
+namespace gen
+{
+
+using namespace tools;
+
+/**
+ * Namespace of generated code, as a chain of frames
+ * A frame holds the names defined while generating one construct, and sees every name of the frames below it,
+ * so generating a construct pushes a frame instead of copying the namespace, and its definitions can be kept or dropped
+ */
+class Names
+{
+public:
+    Names(const Names* set_parent=nullptr);
+
+    Names(const Names&) = delete;
+    Names& operator=(const Names&) = delete;
+
+    bool contains(const string& name) const;
+    void insert(const string& name);
+    void merge(const Names& frame);
+
+private:
+    const Names* parent;
+    unordered_set<int> defined; // Interned names defined in this frame
+};
+
+}
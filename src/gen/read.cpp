@@ -17,24 +17,24 @@ ConditionEvaluator generateConditionEvaluator(vector<string> terms)
     if (keyword == "defined")
     {
         assert(terms.size() == 2);
-        auto identifier = terms[1];
-        return [identifier](unordered_set<string>& names, MultiSymbolTable& ms_table)
+        auto identifier = intern(terms[1]);
+        return [identifier](Names& names, MultiSymbolTable& ms_table)
         {
             assert(contains(ms_table, identifier));
-            auto ms_group = ms_table[identifier];
+            const auto& ms_group = ms_table[identifier];
             assert(not ms_group.empty());
             string to_define = ms_group[0]->name();
-            return contains(names, to_define); 
+            return names.contains(to_define);
         };
     }
     else if (keyword == "equalTo")
     {
         assert(terms.size() == 3);
-        return [terms](unordered_set<string>& names, MultiSymbolTable& ms_table)
+        auto id = intern(terms[1]);
+        return [id, terms](Names& names, MultiSymbolTable& ms_table)
         {
-            auto id = terms[1];
-            assert(contains(ms_table, terms[1]));
-            auto ms_group = ms_table[id];
+            assert(contains(ms_table, id));
+            const auto& ms_group = ms_table[id];
             assert(not ms_group.empty());
             auto name = ms_group[0]->name();
             return name == terms[2]; 
@@ -43,9 +43,9 @@ ConditionEvaluator generateConditionEvaluator(vector<string> terms)
     else if (keyword == "empty")
     {
         assert(terms.size() == 2);
-        return [terms](unordered_set<string>& names, MultiSymbolTable& ms_table)
+        auto id = intern(terms[1]);
+        return [id](Names& names, MultiSymbolTable& ms_table)
         {
-            auto id = terms[1];
             assert(contains(ms_table, id));
             return ms_table[id].empty();
         };
@@ -53,9 +53,9 @@ ConditionEvaluator generateConditionEvaluator(vector<string> terms)
     else if (keyword == "nonempty")
     {
         assert(terms.size() == 2);
-        return [terms](unordered_set<string>& names, MultiSymbolTable& ms_table)
+        auto id = intern(terms[1]);
+        return [id](Names& names, MultiSymbolTable& ms_table)
         {
-            auto id = terms[1];
             assert(contains(ms_table, id));
             return not ms_table[id].empty();
         };
@@ -63,9 +63,9 @@ ConditionEvaluator generateConditionEvaluator(vector<string> terms)
     else if (keyword == "contains")
     {
         assert(terms.size() == 2);
-        return [terms](unordered_set<string>& names, MultiSymbolTable& ms_table)
+        auto id = intern(terms[1]);
+        return [id](Names& names, MultiSymbolTable& ms_table)
         {
-            auto id = terms[1];
             return contains(ms_table, id);
         };
     }
@@ -77,7 +77,7 @@ ConditionEvaluator generateConditionEvaluator(vector<string> terms)
         vector<string> second(split + 1, terms.end());
         auto a = generateConditionEvaluator(first);
         auto b = generateConditionEvaluator(second);
-        return [a, b](unordered_set<string>& names, MultiSymbolTable& ms_table)
+        return [a, b](Names& names, MultiSymbolTable& ms_table)
         {
             return a(names, ms_table) and b(names, ms_table);
         };
@@ -11,11 +11,13 @@ namespace gen
      * Create a branch from lines in a constructor file
      * @param content Lines of constructor file
      * @param ec_creator function defining how to build an element constructor
+     * @param definitions Keys of the symbols whose names the constructor defines
      * @return Branch<string> which will follow user-defined logic to build a syntax element
      */
     template <typename T>
     Branch<T> generateBranch(vector<string> content, 
-                             ElementConstructorCreator<T> ec_creator)
+                             ElementConstructorCreator<T> ec_creator,
+                             const vector<string>& definitions)
     {
         vector<ElementConstructor<T>> line_constructors;
         vector<Branch<T>>             nested_branches;
@@ -30,7 +32,7 @@ namespace gen
         const auto addNestedBranch = [&](auto start, auto end, auto conditionline, bool inverse)
         {
             vector<string> body(start, end);
-            auto nested_branch                = generateBranch(body, ec_creator);
+            auto nested_branch                = generateBranch(body, ec_creator, definitions);
             auto original_condition_terms     = lex::seperate(*conditionline, {make_tuple(" ", false)});
             if (inverse)
             {
@@ -92,7 +94,7 @@ namespace gen
                 }   
                 else if (nest_count == 0)
                 {
-                    line_constructors.push_back(ec_creator(*it));
+                    line_constructors.push_back(ec_creator(*it, definitions));
                 }
             }
             it++;
@@ -138,18 +140,14 @@ namespace gen
             else
             {
                 auto body = vector<string>(last_it + 1, it);
-                auto constructor = Constructor<T>(generateBranch(body,
-                                                      ec_creator),
-                                                      definitions);
+                auto constructor = Constructor<T>(generateBranch(body, ec_creator, definitions));
                 constructors.push_back(make_tuple(type, constructor));
                 last_it = it;
             }
             type = tag;
         }
         auto body = vector<string>(last_it + 1, content.end());
-        auto constructor = Constructor<T>(generateBranch(body,  
-                                              ec_creator), 
-                                          definitions);
+        auto constructor = Constructor<T>(generateBranch(body, ec_creator, definitions));
         constructors.push_back(make_tuple(type, constructor));
         return constructors;
     }
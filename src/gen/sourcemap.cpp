@@ -0,0 +1,126 @@
+/// Copyright 2017 Lucas Saldyt
+#include "sourcemap.hpp"
+
+namespace gen
+{
+
+namespace
+{
+    /// Quotes a string for JSON or a #line directive
+    string quote(const string& text)
+    {
+        string quoted = "\"";
+        for (auto c : text)
+        {
+            if (c == '"' or c == '\\')
+            {
+                quoted += '\\';
+            }
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
+}
+
+/**
+ * Marks the start of code generated from a source line
+ */
+string lineMarker(int line)
+{
+    return line_marker_begin + std::to_string(line) + line_marker_end;
+}
+
+/**
+ * @param set_source Path of the source file
+ * @param set_file Path of the generated file, relative to the output directory
+ * @param set_mode "json" to write a source map next to the file, "lines" for #line directives, or "" for neither
+ */
+SourceMap::SourceMap(string set_source, string set_file, string set_mode) :
+    source(set_source),
+    file(set_file),
+    mode(set_mode)
+{
+}
+
+/**
+ * Removes the line markers from a line of output, keeping track of the line it will be written on
+ * In "lines" mode, a marker at the start of a line becomes a #line directive on its own line before it
+ * @param code Line of output, which may span lines itself
+ * @return The line, as it should be written
+ */
+string SourceMap::apply(const string& code)
+{
+    if (mode.empty())
+    {
+        return code;
+    }
+    if (code.find(line_marker_begin) == string::npos)
+    {
+        generated_line += 1 + std::count(code.begin(), code.end(), '\n');
+        return code;
+    }
+    string result;
+    size_t line_start = 0; // Start of the current line in result
+    for (size_t i = 0; i < code.size(); i++)
+    {
+        if (code[i] == '\n')
+        {
+            generated_line++;
+            line_start = result.size() + 1;
+        }
+        if (code[i] != line_marker_begin)
+        {
+            result += code[i];
+            continue;
+        }
+        auto end = code.find(line_marker_end, i);
+        err_if(end == string::npos, "Unterminated line marker in generated code");
+        int line = std::stoi(code.substr(i + 1, end - i - 1));
+        i = end;
+        if (mode == "lines")
+        {
+            // Directives need a line of their own, so markers after other code on a line are dropped
+            if (result.find_first_not_of(" \t", line_start) == string::npos)
+            {
+                auto directive = "#line " + std::to_string(line) + " " + quote(source) + "\n";
+                result.insert(line_start, directive);
+                line_start += directive.size();
+                generated_line++;
+            }
+        }
+        else if (mappings.empty() or get<0>(mappings.back()) != generated_line)
+        {
+            mappings.push_back(make_tuple(generated_line, line));
+        }
+    }
+    generated_line++;
+    return result;
+}
+
+/**
+ * Writes the source map next to the generated file, as file.map.json, in "json" mode
+ * Each mapping is a [generated line, source line] pair, and lines up to the next mapping come from the same source line
+ * @param directory Output directory
+ */
+void SourceMap::write(string directory) const
+{
+    if (mode != "json")
+    {
+        return;
+    }
+    vector<string> content = {"{",
+                              "    \"version\": 1,",
+                              "    \"file\": " + quote(file) + ",",
+                              "    \"source\": " + quote(source) + ",",
+                              "    \"mappings\": ["};
+    for (size_t i = 0; i < mappings.size(); i++)
+    {
+        content.push_back("        [" + std::to_string(get<0>(mappings[i])) + ", " + std::to_string(get<1>(mappings[i])) + "]" +
+                          (i + 1 < mappings.size() ? "," : ""));
+    }
+    content.push_back("    ]");
+    content.push_back("}");
+    writeFile(content, directory + "/" + file + ".map.json");
+}
+
+}
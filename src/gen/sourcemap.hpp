@@ -0,0 +1,37 @@
+/// Copyright 2017 Lucas Saldyt
+#pragma once
+#include "../tools/tools.hpp"
+
+namespace gen
+{
+
+using namespace tools;
+
+// Generated code holds \x01<line>\x02 where code for a statement from that source line starts, when asked to
+const char line_marker_begin = '\x01';
+const char line_marker_end   = '\x02';
+
+string lineMarker(int line);
+
+/**
+ * Maps the lines of a generated file back to the source lines they were generated from
+ * Reads the line markers the generator leaves in code (see Generator::source_map) as the file is written, and either
+ * records them for a JSON source map written next to the file, or turns them into #line directives (for C-like languages)
+ */
+class SourceMap
+{
+public:
+    SourceMap(string set_source, string set_file, string set_mode);
+
+    string apply(const string& code);
+    void write(string directory) const;
+
+private:
+    string source; // Path of the source file
+    string file;   // Path of the generated file, relative to the output directory
+    string mode;   // "json", "lines", or "" to leave code as it is
+    int generated_line = 1;
+    vector<tuple<int, int>> mappings; // Generated line, and the source line it starts
+};
+
+}
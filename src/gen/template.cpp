@@ -0,0 +1,162 @@
+/// Copyright 2017 Lucas Saldyt
+#include "template.hpp"
+
+namespace gen
+{
+
+namespace
+{
+    /**
+     * Adds literal text, splitting out newlines, and merging into the previous op when it is also text
+     */
+    void addText(vector<TemplateOp>& ops, const string& text)
+    {
+        auto pieces = lex::seperate(substituteKeywords(text), {make_tuple("\n", true)}, {});
+        for (const auto& piece : pieces)
+        {
+            if (piece == "\n")
+            {
+                ops.push_back(TemplateOp{TemplateOpcode::newline, "", "", -1, "", false, false});
+            }
+            else if (not ops.empty() and ops.back().opcode == TemplateOpcode::text)
+            {
+                ops.back().text += piece;
+            }
+            else
+            {
+                ops.push_back(TemplateOp{TemplateOpcode::text, piece, "", -1, "", false, false});
+            }
+        }
+    }
+
+    /**
+     * Compiles text outside of backticks, where symbols to be replaced are surrounded in "$"
+     */
+    void addFormatted(vector<TemplateOp>& ops, const string& line, const vector<string>& definitions)
+    {
+        auto to_format = lex::seperate(line, {make_tuple("$", true)}, {});
+        bool formatting_symbol = false;
+        for (const auto& t : to_format)
+        {
+            if (t == "$")
+            {
+                formatting_symbol = !formatting_symbol;
+            }
+            else if (formatting_symbol)
+            {
+                ops.push_back(TemplateOp{TemplateOpcode::symbol, "", t, intern(t), "", false, contains(definitions, t)});
+            }
+            else
+            {
+                addText(ops, t);
+            }
+        }
+    }
+
+    /**
+     * Compiles the content of backticks, i.e. sep , args @, block body or line
+     */
+    void addSpecial(vector<TemplateOp>& ops, const string& line)
+    {
+        auto terms = lex::seperate(line, {make_tuple(" ", false)});
+        if (terms.empty())
+        {
+            return;
+        }
+        const auto formatter = [&](size_t i)
+        {
+            return terms.size() > i ? substituteKeywords(terms[i]) : "@"s;
+        };
+        auto keyword = terms[0];
+        if (keyword == "sep")
+        {
+            assert(terms.size() == 3 or terms.size() == 4 or terms.size() == 5);
+            auto op = TemplateOp{TemplateOpcode::sep, substituteKeywords(terms[1]), terms[2], intern(terms[2]), formatter(3), false, false};
+            op.multiline = contains(op.text, "\n"s) or contains(op.formatter, "\n"s);
+            ops.push_back(op);
+        }
+        else if (keyword == "block") // e.g. block body @;
+        {
+            assert(terms.size() == 2 or terms.size() == 3);
+            auto op = TemplateOp{TemplateOpcode::block, "", terms[1], intern(terms[1]), formatter(2), false, false};
+            op.multiline = contains(op.formatter, "\n"s);
+            ops.push_back(op);
+        }
+        else if (keyword == "line" and terms.size() == 1) // i.e. to label generated code with where it came from
+        {
+            ops.push_back(TemplateOp{TemplateOpcode::line, "", "", -1, "", false, false});
+        }
+        else
+        {
+            ops.push_back(TemplateOp{TemplateOpcode::invalid, line, "", -1, "", false, false});
+        }
+    }
+}
+
+/**
+ * Replaces the keywords that stand for whitespace
+ * @param text Text from a constructor file
+ * @return Text as it is generated
+ */
+string substituteKeywords(string text)
+{
+    replaceAll(text, "EMPTY",   "");
+    replaceAll(text, "SPACE",   " ");
+    replaceAll(text, "NEWLINE", "\n");
+    replaceAll(text, "INDENT",  "    ");
+    return text;
+}
+
+/**
+ * Starts a new line of code
+ * @param nesting Nesting of the code, where top-level code is at 1 and each block goes one deeper
+ * @return Newline followed by the indentation of the code
+ */
+string newline(int nesting)
+{
+    return "\n" + repeatString("    ", std::max(nesting - 1, 0));
+}
+
+/**
+ * Indents the lines after the first of text that was not generated by a constructor, i.e. a leaf or a separator
+ * @param nesting Nesting of the code the text is part of
+ */
+string indentLines(string text, int nesting)
+{
+    if (nesting > 1)
+    {
+        replaceAll(text, "\n", newline(nesting));
+    }
+    return text;
+}
+
+/**
+ * Parses a line in a constructor file once, into the operations that generate it
+ * @param line Line in constructor file
+ * @param definitions Keys of the symbols whose names the constructor defines
+ * @return Operations, run in order by the generator
+ */
+vector<TemplateOp> compileTemplate(const string& line, const vector<string>& definitions)
+{
+    vector<TemplateOp> ops;
+    auto terms = lex::seperate(line, {make_tuple("`", true)}, {});
+    bool special_formatting = false;
+    for (const auto& t : terms)
+    {
+        if (t == "`")
+        {
+            special_formatting = !special_formatting;
+        }
+        else if (special_formatting)
+        {
+            addSpecial(ops, t);
+        }
+        else
+        {
+            addFormatted(ops, t, definitions);
+        }
+    }
+    return ops;
+}
+
+}
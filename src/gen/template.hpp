@@ -0,0 +1,44 @@
+/// Copyright 2017 Lucas Saldyt
+#pragma once
+#include "../tools/tools.hpp"
+#include "../lex/seperate.hpp"
+
+namespace gen
+{
+
+using namespace tools;
+
+/**
+ * Kinds of operations in a compiled constructor line
+ */
+enum class TemplateOpcode
+{
+    text,    // Literal text without newlines, with EMPTY, SPACE and INDENT already replaced
+    newline, // NEWLINE, followed by the indentation of the current nesting
+    symbol,  // $key$, the code of the only symbol under key
+    sep,     // `sep separator key formatter`
+    block,   // `block key formatter`, symbols one per line, one level deeper
+    line,    // `line`, the source line of the symbol being generated, or 0 if it wasn't read from the source
+    invalid  // Unknown special constructor, which throws when run
+};
+
+/**
+ * One operation in a compiled constructor line: each appends a single piece of code
+ */
+struct TemplateOp
+{
+    TemplateOpcode opcode;
+    string text;      // Literal text, separator of a sep, or the line for an invalid op
+    string key;       // Key in the multi symbol table
+    int tag;          // Interned key
+    string formatter; // Each symbol's code replaces @ in it
+    bool multiline;   // Whether the separator or formatter contains newlines, which are indented when run
+    bool defines;     // Whether the symbol's name is added to the namespace, because its key is listed under defines
+};
+
+vector<TemplateOp> compileTemplate(const string& line, const vector<string>& definitions);
+string substituteKeywords(string text);
+string newline(int nesting);
+string indentLines(string text, int nesting);
+
+}
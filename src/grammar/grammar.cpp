@@ -3,14 +3,15 @@
 
 namespace grammar
 {
-shared_ptr<Symbol> annotateSymbol(shared_ptr<Symbol> s, string annotation)
+Symbol* annotateSymbol(Symbol* s, string annotation)
 {
     s->annotation = annotation;
     return s;
 }
 
 /// Standard grammar constructor (From list of files)
-Grammar::Grammar(string directory) 
+Grammar::Grammar(string directory) :
+    budget(make_shared<ParseBudget>())
 {
     readInherits(directory + "inherits");
 
@@ -27,22 +28,17 @@ Grammar::Grammar(string directory)
  * @param logger OutputManager to track verbose output
  * @return vector of annotated matrices, each representing a high level symbolic type (statement)
  */
-IdentifiedGroups Grammar::identifyGroups(vector<SymbolicToken>& tokens, OutputManager logger)
+IdentifiedGroups Grammar::identifyGroups(TokenStream& tokens, OutputManager logger)
 {
     logger.log("Identifying groups with grammar");
     IdentifiedGroups identified_groups;
+    int position = 0;
     try 
     {
         // Consume all tokens
-        while (tokens.size() > 0)
+        while (position < tokens.size())
         {
-            // Tag groups of tokens as certain lexmap constructs
-            logger.log("Attempting identification of remaining " + std::to_string(tokens.size()) + " tokens");
-            auto result = identify(tokens, logger);
-            logger.log("Identified group as " + get<0>(result) + ", grouping..");
-            auto ms_table = createMultiSymbolTable(get<0>(result), get<1>(result));
-            identified_groups.push_back(make_tuple(get<0>(result), ms_table));
-            logger.log("Group creation finished. " + std::to_string(tokens.size()) + " tokens remaining");
+            identified_groups.push_back(identifyNext(tokens, position, logger));
         }
     }
     catch (...) // Print the info we have so far, then re-raise any error 
@@ -59,20 +55,54 @@ IdentifiedGroups Grammar::identifyGroups(vector<SymbolicToken>& tokens, OutputMa
                 }
             }
         }
-        int line = tokens[0].line;
+        throw; // Very important
+    }
+    logger.log("Group identification finished. " + std::to_string(identified_groups.size()) + " groups created");
+    logger.log("Identification took " + std::to_string(budget->steps()) + " matching steps");
+
+    return identified_groups;
+}
+
+/**
+ * Identify the single top-level construct (statement) that starts at a position
+ * Starting from position 0 begins a new file, which resets the parse budget
+ * @param tokens   Stream of tokens to be identified
+ * @param position Position of the statement, advanced past it on success
+ * @param logger   OutputManager to track verbose output
+ * @return Annotated matrix representing the statement
+ */
+IdentifiedGroup Grammar::identifyNext(TokenStream& tokens, int& position, OutputManager logger)
+{
+    if (position == 0)
+    {
+        budget->reset();
+    }
+    try
+    {
+        // Tag groups of tokens as certain lexmap constructs
+        logger.log("Attempting identification of remaining " + std::to_string(tokens.size() - position) + " tokens");
+        auto result = identify(tokens, position, logger);
+        logger.log("Identified group as " + get<0>(result) + ", grouping..");
+        auto ms_table = createMultiSymbolTable(get<0>(result), tokens, get<1>(result));
+        logger.log("Group creation finished. " + std::to_string(tokens.size() - position) + " tokens remaining");
+        return make_tuple(get<0>(result), ms_table);
+    }
+    catch (...) // Show where identification stopped, then re-raise any error 
+    {
+        int line = tokens.line(position);
         logger.log("Failed on line: " + std::to_string(line));
         logger.log("Remaining:");
         string first = "";
         string second = "";
-        for (auto token : tokens)
+        for (int i = position; i < tokens.size(); i++)
         {
-            if (token.line == line)
+            if (tokens.lines[i] == line)
             {
-                first += token.text + " ";
+                first += tokens.tokenText(i) + " ";
             }
-            else if (token.line == line + 1)
+            else if (tokens.lines[i] == line + 1)
             {
-                second += token.text + " ";
+                second += tokens.tokenText(i) + " ";
             }
             else
             {
@@ -80,11 +110,25 @@ IdentifiedGroups Grammar::identifyGroups(vector<SymbolicToken>& tokens, OutputMa
             }
         }
         print(first + "(" + std::to_string(line) + ")", second + "(" + std::to_string(line + 1) + ")");
-        throw; // Very important
+        throw;
     }
-    logger.log("Group identification finished. " + std::to_string(identified_groups.size()) + " groups created");
+}
 
-    return identified_groups;
+/**
+ * Limit the matching work that identifyGroups may spend on a single file
+ * @param max_steps   Maximum number of matcher invocations (0 for no limit)
+ * @param max_seconds Maximum wall time in seconds (0 for no limit)
+ */
+void Grammar::setBudget(long max_steps, double max_seconds)
+{
+    budget->max_steps   = max_steps;
+    budget->max_seconds = max_seconds;
+}
+
+/// Hash of the grammar's source, which changes whenever any grammar file it was read from does
+uint64_t Grammar::sourceHash() const
+{
+    return source_hash;
 }
 
 vector<string> Grammar::seperateGrammarLine(string line)
@@ -119,31 +163,32 @@ vector<string> Grammar::seperateGrammarLine(string line)
 
 /**
  * Discards unwanted tokens marked by the user
+ * Discarded tokens and seperators are skipped in the same pass that groups symbols by tag
  * @param name    Annotation for higher level syntactic construct (statement)
+ * @param tokens  Stream the results were matched against
  * @param results Results of matching against a given statement
  * @return        2D matrix of Symbols
  */
 
-MultiSymbolTable Grammar::createMultiSymbolTable(string name, vector<Result<SymbolicToken>> results)
+MultiSymbolTable Grammar::createMultiSymbolTable(string name, TokenStream& tokens, const vector<TokenResult>& results)
 {
-    auto index_tags = get<1>(grammar_map[name]);
+    const auto& index_tags = get<1>(grammar_map[name]);
     
     MultiSymbolTable ms_table;
 
-    for (auto t : index_tags)
+    for (const auto& t : index_tags)
     {
-        auto i = get<0>(t);
-        auto tag = get<1>(t);
-        auto result = results[i];
-        result.consumed = clean(result.consumed); // Discard tokens that have been marked as unneeded
-
-        auto grouped_tokens = reSeperate(result.consumed); // Expand multi-token parsers
-        vector<shared_ptr<Symbol>> ms_group;
-        for (auto group : grouped_tokens)
+        const auto& consumed = results[get<0>(t)].consumed;
+        SymbolList ms_group;
+        ms_group.reserve(consumed.size());
+        for (const auto& token : consumed)
         {
-            concat(ms_group, fromTokens(group));
+            if (not token.marker())
+            {
+                ms_group.push_back(tokens.symbol(token));
+            }
         }
-        ms_table[tag] = ms_group;
+        ms_table[get<1>(t)] = std::move(ms_group);
     }
     return ms_table;
 }
@@ -328,7 +373,7 @@ SymbolicTokenParser Grammar::readGrammarTerms(vector<string>& terms)
         }
         else
         {
-            parser = inOrder<SymbolicToken>(readGrammarPairs(terms));
+            parser = inOrder(readGrammarPairs(terms));
         }
     }
     if (not keep)
@@ -336,7 +381,7 @@ SymbolicTokenParser Grammar::readGrammarTerms(vector<string>& terms)
         parser = discard(parser);
     }
 
-    return parser;
+    return budgeted(parser, budget, reading_rule);
 }
 
 /**
@@ -348,9 +393,10 @@ SymbolicTokenParser Grammar::readGrammarTerms(vector<string>& terms)
  */
 SymbolicTokenParser Grammar::retrieveGrammar(string filename)
 {
-    return [filename, this](vector<SymbolicToken> tokens)
+    int type = intern(filename);
+    return [filename, type, this](TokenStream& tokens, int position)
     {
-        std::vector<SymbolicTokenParser> parsers;
+        budget->step(filename, tokens.line(position));
 
         string tag = filename;
 
@@ -363,19 +409,21 @@ SymbolicTokenParser Grammar::retrieveGrammar(string filename)
         {
             if (not contains(grammar_map, tag)) break;
 
-            parsers = get<0>(grammar_map[tag]);
-            vector<SymbolicToken> tokens_copy(tokens);
-            auto result = evaluateGrammar(parsers, tokens_copy, OutputManager(0));
+            const auto& parsers = get<0>(grammar_map[tag]);
+            int end = position;
+            auto result = evaluateGrammar(parsers, tokens, end, OutputManager(0));
             if (get<0>(result))
             {
-                auto ms_table    = createMultiSymbolTable(filename, get<1>(result));
-                auto constructed = make_shared<MultiSymbol>(MultiSymbol(filename, ms_table));
-                auto consumed    = vector<SymbolicToken>(1, SymbolicToken(constructed, filename, filename, ""));
-                return Result<SymbolicToken>(true, consumed, tokens_copy); 
+                auto ms_table    = createMultiSymbolTable(filename, tokens, get<1>(result));
+                int  line        = firstLine(ms_table);
+                auto constructed = tokens.arena.make<MultiSymbol>(filename, std::move(ms_table));
+                constructed->line = line;
+                auto consumed    = vector<SymbolicToken>(1, SymbolicToken(constructed, type));
+                return TokenResult(true, consumed, end); 
             }
             tag += "_inherit";
         }
-        return Result<SymbolicToken>(false, {}, tokens);
+        return TokenResult(false, {}, position);
     };
 }
 
@@ -386,30 +434,24 @@ SymbolicTokenParser Grammar::retrieveGrammar(string filename)
  * @param logger OutputManager for managing verbose output
  * @return Tuple of the form (annotation, results) where results are the collective match attempts against a particular (successful) syntax element
  */
-tuple<string, vector<Result<SymbolicToken>>> 
+tuple<string, vector<TokenResult>> 
 Grammar::identify
-(vector<SymbolicToken>& tokens, OutputManager logger)
+(TokenStream& tokens, int& position, OutputManager logger)
 {
-    vector<SymbolicToken> tokens_copy(tokens);
-
     assert(contains(grammar_map, "statement"));
 
     string statement_tag = "statement";
     while (true)
     {
         if (not contains(grammar_map, statement_tag)) break;
-        auto statement = grammar_map[statement_tag]; 
-        auto parsers   = get<0>(statement);
-        auto result    = evaluateGrammar(parsers, tokens_copy, logger);
+        const auto& parsers = get<0>(grammar_map[statement_tag]);
+        int end = position;
+        auto result = evaluateGrammar(parsers, tokens, end, logger);
         if (get<0>(result))
         {
-            tokens = tokens_copy; // Apply our changes once we know the tokens were positively identified
+            position = end; // Apply our changes once we know the tokens were positively identified
             return make_tuple("statement", get<1>(result));
         }
-        else
-        {
-            tokens_copy = tokens;
-        }
         statement_tag += "_inherit";
     }
 
@@ -423,19 +465,19 @@ Grammar::identify
  * @param logger OutputManager for managing verbose output
  * @return Tuple of the form (result, results) where result is boolean, and results are Result<T> classes
  */
-tuple<bool, vector<Result<SymbolicToken>>> 
+tuple<bool, vector<TokenResult>> 
 Grammar::evaluateGrammar
-(vector<SymbolicTokenParser> parsers, vector<SymbolicToken>& tokens, OutputManager logger)
+(const vector<SymbolicTokenParser>& parsers, TokenStream& tokens, int& position, OutputManager logger)
 {
-    vector<Result<SymbolicToken>> results;
+    vector<TokenResult> results;
 
     int i = 0;
-    for (auto parser : parsers)
+    for (auto& parser : parsers)
     {
-        auto result = parser(tokens);
+        auto result = parser(tokens, position);
         if (result.result)
         {
-            tokens = result.remaining;
+            position = result.position;
             results.push_back(result);
         }
         else // Fail early if possible
@@ -450,14 +492,16 @@ Grammar::evaluateGrammar
 
 void Grammar::read(string line)
 {
+    source_hash = contentHash(line, source_hash);
     auto terms = seperateGrammarLine(line);
     if (terms.empty()) return;
     auto tag = terms[0];
     replaceAll(tag, ":", "");
     print("Read grammar construct: " + tag);
+    reading_rule = tag;
     terms = slice(terms, 1);
     vector<SymbolicTokenParser> parsers;
-    vector<tuple<int, string>> index_tags;
+    vector<tuple<int, int>> index_tags; // Parser index and interned tag of each tagged term
     int i = 0;
     for (auto t : terms)
     {
@@ -469,7 +513,7 @@ void Grammar::read(string line)
             replaceAll(beginterm, "@", "");
             interms = slice(interms, 1);
             parsers.push_back(readGrammarTerms(interms));
-            index_tags.push_back(make_tuple(i, beginterm));
+            index_tags.push_back(make_tuple(i, intern(beginterm)));
         }
         else
         {
@@ -491,22 +535,6 @@ void Grammar::read(string line)
     grammar_map[nested_tag] = current;
 }
 
-/**
- * Discard type information from vector<SymbolicToken>
- */
-vector<shared_ptr<Symbol>> fromTokens(vector<SymbolicToken> tokens)
-{
-    vector<shared_ptr<Symbol>> symbols;
-    symbols.reserve(tokens.size());
-
-    for (auto t : tokens)
-    {
-        symbols.push_back(t.value); // t.type and t.sub_type are discarded
-    }
-
-    return symbols;
-}
-
 void Grammar::readInherits(string inherit_file)
 {
     print("Reading language inherits from " + inherit_file);
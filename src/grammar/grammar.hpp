@@ -18,17 +18,16 @@ using namespace match;
 using namespace syntax;
 using namespace tools;
 
-using IdentifiedGroups = vector<tuple<string, MultiSymbolTable>>;
-using GrammarMap = unordered_map<string, tuple<vector<SymbolicTokenParser>, vector<tuple<int, string>>>>; 
+using IdentifiedGroup  = tuple<string, MultiSymbolTable>;
+using IdentifiedGroups = vector<IdentifiedGroup>;
+using GrammarMap = unordered_map<string, tuple<vector<SymbolicTokenParser>, vector<tuple<int, int>>>>; 
 
-vector<shared_ptr<Symbol>> fromTokens(vector<SymbolicToken>);
-
-shared_ptr<Symbol> annotateSymbol(shared_ptr<Symbol> s, string annotation);
+Symbol* annotateSymbol(Symbol* s, string annotation);
 
 template <typename T> 
-shared_ptr<Symbol> createSymbol(T t, string annotation)
+Symbol* createSymbol(Arena& arena, T t, string annotation)
 {
-    return annotateSymbol(make_shared<T>(t), annotation);
+    return annotateSymbol(arena.make<T>(t), annotation);
 }
 
 /**
@@ -40,11 +39,19 @@ class Grammar
 public:
     Grammar(string directory); 
 
-    IdentifiedGroups identifyGroups(vector<SymbolicToken>& tokens, OutputManager logger);
+    IdentifiedGroups identifyGroups(TokenStream& tokens, OutputManager logger);
+    IdentifiedGroup  identifyNext(TokenStream& tokens, int& position, OutputManager logger);
+
+    void setBudget(long max_steps, double max_seconds);
+    uint64_t sourceHash() const;
 
     vector<string> keywords;
 
 private:
+    shared_ptr<ParseBudget> budget;
+    string reading_rule = "none";
+    uint64_t source_hash = hash_seed; // Of every grammar line read, including inherited grammars
+
     void read(string filename);
 
     void readGrammarFile(string filename);
@@ -53,10 +60,10 @@ private:
 
     void readSymbolFile(vector<string> symbol_file);
 
-    tuple<string, vector<Result<SymbolicToken>>> identify (vector<SymbolicToken>& tokens, OutputManager logger);
-    MultiSymbolTable createMultiSymbolTable(string name, vector<Result<SymbolicToken>> results);
+    tuple<string, vector<TokenResult>> identify (TokenStream& tokens, int& position, OutputManager logger);
+    MultiSymbolTable createMultiSymbolTable(string name, TokenStream& tokens, const vector<TokenResult>& results);
 
-    tuple<bool, vector<Result<SymbolicToken>>> evaluateGrammar(vector<SymbolicTokenParser> parsers, vector<SymbolicToken>& tokens, OutputManager logger);
+    tuple<bool, vector<TokenResult>> evaluateGrammar(const vector<SymbolicTokenParser>& parsers, TokenStream& tokens, int& position, OutputManager logger);
 
     vector<SymbolicTokenParser> readAnyOf(vector<string>& terms);
     vector<SymbolicTokenParser> readGrammarPairs(vector<string>& terms);
@@ -0,0 +1,31 @@
+/// Copyright 2017 Lucas Saldyt
+#include "compiler.hpp"
+
+/**
+ * Demonstration of very high-level compiler usage
+ */
+int main(int argc, char* argv[])
+{
+    using namespace compiler;
+
+    vector<string> args;
+    for (int i = 1; i < argc; i++)
+    {
+        args.push_back(argv[i]);
+    }
+
+    auto options = readOptions(args);
+
+    assert(args.size() > 3);
+
+    int verbosity = std::stoi(args[0]);
+
+    string from = args[1];
+    string to   = args[2];
+    vector<string> files = slice(args, 3);
+
+    auto aborted = compileFiles(files, "input", from, "output", to, verbosity, options);
+    print("Compilation finished");
+    // Callers (i.e. batch jobs) need to tell when a file was given up on, even though the others were compiled
+    return aborted.empty() ? 0 : 1;
+}
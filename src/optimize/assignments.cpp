@@ -0,0 +1,151 @@
+/// Copyright 2017 Lucas Saldyt
+#include "passes.hpp"
+#include "evaluate.hpp"
+
+namespace optimize
+{
+
+namespace
+{
+    /// Counts every identifier under a node, whether it is read, assigned, called, or a parameter
+    void countNames(MultiSymbolTable& ms_table, unordered_map<string, int>& counts)
+    {
+        for (auto kv : ms_table)
+        {
+            for (auto symbol : kv.second)
+            {
+                if (auto identifier = dynamic_cast<Identifier*>(symbol))
+                {
+                    counts[identifier->value]++;
+                }
+                symbol->visit([&](string&, MultiSymbolTable& child_table){ countNames(child_table, counts); });
+            }
+        }
+    }
+
+    /// Whether evaluating a value can't have effects: only literals, names and arithmetic that can't raise, no calls
+    bool pure(Symbol* symbol)
+    {
+        auto multi = dynamic_cast<MultiSymbol*>(symbol);
+        if (multi == nullptr)
+        {
+            auto op = dynamic_cast<StringLiteral*>(symbol);
+            return op == nullptr or (op->value != "/" and op->value != "//" and op->value != "%");
+        }
+        const unordered_set<string> pure_tags = {"boolexpression", "expression", "value", "basevalue", "parenexpr", "string"};
+        if (not contains(pure_tags, multi->tag))
+        {
+            return false;
+        }
+        for (auto kv : multi->table)
+        {
+            for (auto child : kv.second)
+            {
+                if (not pure(child))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /// Name assigned by a statement like x = ..., or "" for any other statement
+    string assignedName(Symbol* statement)
+    {
+        auto assignment = statementOf(statement, "assignment");
+        if (assignment == nullptr)
+        {
+            return "";
+        }
+        auto lval = dynamic_cast<Identifier*>(only(assignment->table, "lval"));
+        auto op   = dynamic_cast<StringLiteral*>(only(assignment->table, "op"));
+        return lval == nullptr or op == nullptr or op->value != "=" ? "" : lval->value;
+    }
+
+    /**
+     * Removes the assignments of a function to names that appear nowhere else in it, and whose values have no effects
+     * @return Number of assignments removed
+     */
+    int removeFrom(MultiSymbolTable& function_table, const string& function, OutputManager logger)
+    {
+        unordered_map<string, int> counts;
+        countNames(function_table, counts);
+        unordered_map<string, int> assignments;
+        string tag = "function";
+        postorder(tag, function_table, [&](string&, MultiSymbolTable& ms_table)
+        {
+            for (auto kv : ms_table)
+            {
+                for (auto symbol : kv.second)
+                {
+                    auto name = assignedName(symbol);
+                    if (not name.empty())
+                    {
+                        assignments[name]++;
+                    }
+                }
+            }
+        });
+
+        int removed = 0;
+        postorder(tag, function_table, [&](string&, MultiSymbolTable& ms_table)
+        {
+            for (auto kv : ms_table)
+            {
+                SymbolList statements;
+                vector<string> names;
+                for (auto symbol : kv.second)
+                {
+                    auto name = assignedName(symbol);
+                    if (name.empty() or counts[name] != assignments[name] or
+                        not pure(only(statementOf(symbol, "assignment")->table, "rval")))
+                    {
+                        statements.push_back(symbol);
+                        continue;
+                    }
+                    names.push_back(name);
+                }
+                if (names.empty() or statements.empty())
+                {
+                    continue;
+                }
+                for (auto name : names)
+                {
+                    logger.log("unused-assignments: removed an assignment to " + name + " in " + function, 2);
+                }
+                kv.second = statements;
+                removed += names.size();
+            }
+        });
+        return removed;
+    }
+}
+
+/**
+ * Removes assignments to local variables that are never read, when computing the assigned value has no effects
+ * A name counts as read if it appears anywhere else in the function, including nested functions and lambdas.
+ * Removing an assignment can leave others unused (i.e. y = 1, x = y), so functions are rescanned until nothing changes
+ */
+int removeUnusedAssignments(IdentifiedGroup& identified_group, Arena& arena, OutputManager logger)
+{
+    int changes = 0;
+    postorder(get<0>(identified_group), get<1>(identified_group), [&](string& tag, MultiSymbolTable& ms_table)
+    {
+        if (tag != "function" and tag != "memberfunction")
+        {
+            return;
+        }
+        auto identifier = dynamic_cast<Identifier*>(only(ms_table, "identifier"));
+        string function = identifier == nullptr ? tag : identifier->value;
+        int removed = 0;
+        do
+        {
+            removed = removeFrom(ms_table, function, logger);
+            changes += removed;
+        } while (removed > 0);
+    });
+    return changes;
+}
+
+}
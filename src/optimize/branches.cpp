@@ -0,0 +1,172 @@
+/// Copyright 2017 Lucas Saldyt
+#include "passes.hpp"
+#include "evaluate.hpp"
+
+namespace optimize
+{
+
+namespace
+{
+    SymbolList bodyOf(MultiSymbol* node)
+    {
+        static const int body_id = intern("body");
+        auto body = node->table.find(body_id);
+        return body == nullptr ? SymbolList() : *body;
+    }
+
+    /**
+     * Drops the elifs of an if whose conditions are always false, and turns the first one that is always true into the else
+     * Then, if the if's own condition is always false, its first elif takes its place
+     * @return Number of changes
+     */
+    int pruneBranches(MultiSymbolTable& if_table, Arena& arena, OutputManager logger)
+    {
+        auto branch = only(if_table, "branches", "branch");
+        static const int elifs_id = intern("elifs");
+        auto elifs  = branch == nullptr ? nullptr : branch->table.find(elifs_id);
+        if (elifs == nullptr)
+        {
+            return 0;
+        }
+        int changes = 0;
+        SymbolList kept;
+        Symbol* always = nullptr; // Else made from an elif that is always taken
+        for (auto symbol : *elifs)
+        {
+            auto elif = dynamic_cast<MultiSymbol*>(symbol);
+            bool condition;
+            if (elif == nullptr or not truth(only(elif->table, "condition", "boolexpression"), condition))
+            {
+                kept.push_back(symbol);
+                continue;
+            }
+            changes++;
+            if (not condition)
+            {
+                logger.log("dead-branches: removed an elif whose condition is always false", 2);
+                continue;
+            }
+            // Branches after this one are never reached
+            MultiSymbolTable else_table;
+            else_table["body"] = bodyOf(elif);
+            always = arena.make<MultiSymbol>("else", else_table);
+            logger.log("dead-branches: replaced the branches after an elif whose condition is always true by its body", 2);
+            break;
+        }
+        if (changes == 0)
+        {
+            return 0;
+        }
+        branch->table["elifs"] = kept;
+        if (always != nullptr)
+        {
+            branch->table["else"] = SymbolList({always});
+        }
+
+        bool condition;
+        if (not kept.empty() and truth(only(if_table, "condition", "boolexpression"), condition) and not condition)
+        {
+            auto elif = dynamic_cast<MultiSymbol*>(kept[0]);
+            if_table["condition"] = elif->table["condition"];
+            if_table["body"]      = bodyOf(elif);
+            kept.erase(kept.begin());
+            branch->table["elifs"] = kept;
+            logger.log("dead-branches: replaced an if whose condition is always false by its first elif", 2);
+            changes++;
+        }
+        return changes;
+    }
+
+    /**
+     * Statements that a statement can be replaced with, because it is an if or whileloop whose condition is constant
+     * @param replacement Set to the statements that run instead: the body or else of an if, or none
+     * @param description Set to a description of the change
+     * @return false if the statement has to stay
+     */
+    bool deadStatement(Symbol* statement, SymbolList& replacement, string& description)
+    {
+        bool condition;
+        if (auto node = statementOf(statement, "if"))
+        {
+            auto branch = only(node->table, "branches", "branch");
+            static const int elifs_id = intern("elifs");
+            auto elifs  = branch == nullptr ? nullptr : branch->table.find(elifs_id);
+            if (not truth(only(node->table, "condition", "boolexpression"), condition) or
+                (not condition and elifs != nullptr and not elifs->empty()))
+            {
+                return false;
+            }
+            if (condition)
+            {
+                replacement = bodyOf(node);
+                description = "replaced an if whose condition is always true by its body";
+                return true;
+            }
+            auto otherwise = branch == nullptr ? nullptr : only(branch->table, "else", "else");
+            replacement = otherwise == nullptr ? SymbolList() : bodyOf(otherwise);
+            description = otherwise == nullptr ? "removed an if whose condition is always false" :
+                                                 "replaced an if whose condition is always false by its else";
+            return true;
+        }
+        if (auto node = statementOf(statement, "whileloop"))
+        {
+            if (truth(only(node->table, "boolexpr", "boolexpression"), condition) and not condition)
+            {
+                replacement = SymbolList();
+                description = "removed a whileloop whose condition is always false";
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+/**
+ * Removes the branches of ifs and whileloops that can never run, because their conditions are constant
+ * (True or False, or comparisons of numbers), and unwraps the branches that always run
+ * Top-level statements are kept, and so are bodies that would be left empty
+ */
+int removeDeadBranches(IdentifiedGroup& identified_group, Arena& arena, OutputManager logger)
+{
+    int changes = 0;
+    postorder(get<0>(identified_group), get<1>(identified_group), [&](string& tag, MultiSymbolTable& ms_table)
+    {
+        if (tag == "if")
+        {
+            changes += pruneBranches(ms_table, arena, logger);
+        }
+        for (auto kv : ms_table)
+        {
+            SymbolList statements;
+            vector<string> descriptions;
+            for (auto symbol : kv.second)
+            {
+                SymbolList replacement;
+                string description;
+                if (not deadStatement(symbol, replacement, description))
+                {
+                    statements.push_back(symbol);
+                    continue;
+                }
+                for (auto replaced : replacement)
+                {
+                    statements.push_back(replaced);
+                }
+                descriptions.push_back(description);
+            }
+            if (descriptions.empty() or statements.empty())
+            {
+                continue;
+            }
+            for (auto description : descriptions)
+            {
+                logger.log("dead-branches: " + description, 2);
+            }
+            kv.second = statements;
+            changes += descriptions.size();
+        }
+    });
+    return changes;
+}
+
+}
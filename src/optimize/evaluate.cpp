@@ -0,0 +1,320 @@
+/// Copyright 2017 Lucas Saldyt
+#include "evaluate.hpp"
+#include <climits>
+#include <cmath>
+
+namespace optimize
+{
+
+namespace
+{
+    /// Text of an operator or other punctuation leaf, or "" for any other symbol
+    string operatorText(Symbol* symbol)
+    {
+        auto literal = dynamic_cast<StringLiteral*>(symbol);
+        return literal == nullptr or dynamic_cast<Identifier*>(symbol) != nullptr ? "" : literal->value;
+    }
+
+    /**
+     * Applies a binary operator to constants, the way both python and C-like targets would
+     * @return false if the operator isn't understood, or the targets could disagree on the result
+     */
+    bool apply(const string& op, const Constant& a, const Constant& b, Constant& result)
+    {
+        if (op != "+" and op != "-" and op != "*" and op != "/")
+        {
+            return false;
+        }
+        if (a.integral and b.integral)
+        {
+            if (op == "/") // Truncates in C-like targets, but gives a float in python3
+            {
+                return false;
+            }
+            long long value = op == "+" ? (long long)a.integer + b.integer :
+                              op == "-" ? (long long)a.integer - b.integer :
+                                          (long long)a.integer * b.integer;
+            if (value < INT_MIN or value > INT_MAX)
+            {
+                return false;
+            }
+            result = Constant{true, (int)value, 0.};
+            return true;
+        }
+        if (op == "/" and b.number() == 0.)
+        {
+            return false;
+        }
+        double value = op == "+" ? a.number() + b.number() :
+                       op == "-" ? a.number() - b.number() :
+                       op == "*" ? a.number() * b.number() :
+                                   a.number() / b.number();
+        if (not std::isfinite(value))
+        {
+            return false;
+        }
+        result = Constant{false, 0, value};
+        return true;
+    }
+
+    /// Whether a leaf spells a boolean constant (symbol tables may have converted True to true)
+    bool booleanLeaf(Symbol* symbol, bool& result)
+    {
+        auto literal = dynamic_cast<StringLiteral*>(symbol);
+        if (literal == nullptr)
+        {
+            return false;
+        }
+        if (literal->value == "True" or literal->value == "true")
+        {
+            result = true;
+            return true;
+        }
+        if (literal->value == "False" or literal->value == "false")
+        {
+            result = false;
+            return true;
+        }
+        return false;
+    }
+}
+
+double Constant::number() const
+{
+    return integral ? integer : real;
+}
+
+string Constant::text() const
+{
+    return integral ? std::to_string(integer) : std::to_string(real);
+}
+
+/**
+ * Calls visitor on every MultiSymbol under a node, children before their parents, and then on the node itself
+ */
+void postorder(string& tag, MultiSymbolTable& ms_table, const function<void(string&, MultiSymbolTable&)>& visitor)
+{
+    for (auto kv : ms_table)
+    {
+        for (auto symbol : kv.second)
+        {
+            symbol->visit([&](string& child_tag, MultiSymbolTable& child_table)
+            {
+                postorder(child_tag, child_table, visitor);
+            });
+        }
+    }
+    visitor(tag, ms_table);
+}
+
+/**
+ * The only symbol under a key, or nullptr if there isn't exactly one
+ */
+Symbol* only(MultiSymbolTable& ms_table, const string& key)
+{
+    auto symbols = ms_table.find(intern(key));
+    return symbols == nullptr or symbols->size() != 1 ? nullptr : (*symbols)[0];
+}
+
+/**
+ * The only symbol under a key, if it is a MultiSymbol with the given tag, otherwise nullptr
+ */
+MultiSymbol* only(MultiSymbolTable& ms_table, const string& key, const string& tag)
+{
+    auto multi = dynamic_cast<MultiSymbol*>(only(ms_table, key));
+    return multi != nullptr and multi->tag == tag ? multi : nullptr;
+}
+
+/**
+ * The node a statement wraps, i.e. the if of statement(val=if(...)), or nullptr if it wraps something else
+ */
+MultiSymbol* statementOf(Symbol* statement, const string& tag)
+{
+    auto multi = dynamic_cast<MultiSymbol*>(statement);
+    return multi == nullptr or multi->tag != "statement" ? nullptr : only(multi->table, "val", tag);
+}
+
+/**
+ * Value of a value node that is a numeric literal, or a parenthesized constant expression
+ * @return false if the value isn't constant
+ */
+bool constantValue(Symbol* value, Constant& result)
+{
+    auto multi = dynamic_cast<MultiSymbol*>(value);
+    if (multi == nullptr or multi->tag != "value")
+    {
+        return false;
+    }
+    if (auto basevalue = only(multi->table, "val", "basevalue"))
+    {
+        auto leaf = only(basevalue->table, "val");
+        if (auto integer = dynamic_cast<Integer*>(leaf))
+        {
+            result = Constant{true, integer->value, 0.};
+            return true;
+        }
+        if (auto real = dynamic_cast<Double*>(leaf))
+        {
+            result = Constant{false, 0, real->value};
+            return true;
+        }
+        return false;
+    }
+    auto parenexpr  = only(multi->table, "val", "parenexpr");
+    auto expression = parenexpr == nullptr ? nullptr : only(parenexpr->table, "expr", "expression");
+    return expression != nullptr and evaluate(expression, result);
+}
+
+/**
+ * Evaluates part of the body of an expression: values separated by operators, with * and / binding tighter than + and -
+ * @param begin Index of the first value
+ * @param end   Index after the last value
+ * @return false if any value isn't constant, or an operator can't be applied (see apply)
+ */
+bool evaluate(const SymbolList& body, size_t begin, size_t end, Constant& result)
+{
+    if (begin >= end or (end - begin) % 2 == 0)
+    {
+        return false;
+    }
+    Constant sum;
+    Constant term;
+    string additive = ""; // Operator before the current term, or "" before the first term
+    const auto addTerm = [&]()
+    {
+        return additive.empty() ? (sum = term, true) : apply(additive, sum, term, sum);
+    };
+    for (size_t i = begin; i < end; i += 2)
+    {
+        Constant operand;
+        if (not constantValue(body[i], operand))
+        {
+            return false;
+        }
+        string op = i == begin ? "" : operatorText(body[i - 1]);
+        if (op == "*" or op == "/")
+        {
+            if (not apply(op, term, operand, term))
+            {
+                return false;
+            }
+        }
+        else if (op == "+" or op == "-")
+        {
+            if (not addTerm())
+            {
+                return false;
+            }
+            additive = op;
+            term     = operand;
+        }
+        else if (i == begin)
+        {
+            term = operand;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    if (not addTerm())
+    {
+        return false;
+    }
+    result = sum;
+    return true;
+}
+
+/**
+ * Evaluates an expression node
+ * @return false if it isn't constant
+ */
+bool evaluate(MultiSymbol* expression, Constant& result)
+{
+    static const int body_id = intern("body");
+    auto body = expression->table.find(body_id);
+    return body != nullptr and evaluate(*body, 0, body->size(), result);
+}
+
+/**
+ * Truth of a condition that doesn't depend on the program: True or False, a constant number,
+ * or a comparison of two constant expressions
+ * @param boolexpression Condition, i.e. of an if or whileloop
+ * @return false if the condition isn't constant
+ */
+bool truth(MultiSymbol* boolexpression, bool& result)
+{
+    static const int body_id = intern("body");
+    auto body = boolexpression == nullptr ? nullptr : boolexpression->table.find(body_id);
+    if (body == nullptr)
+    {
+        return false;
+    }
+    if (body->size() == 1)
+    {
+        auto expression = dynamic_cast<MultiSymbol*>((*body)[0]);
+        if (expression == nullptr or expression->tag != "expression")
+        {
+            return false;
+        }
+        auto value     = only(expression->table, "body", "value");
+        auto basevalue = value == nullptr ? nullptr : only(value->table, "val", "basevalue");
+        if (basevalue != nullptr and booleanLeaf(only(basevalue->table, "val"), result))
+        {
+            return true;
+        }
+        Constant constant;
+        if (not evaluate(expression, constant))
+        {
+            return false;
+        }
+        result = constant.number() != 0.;
+        return true;
+    }
+    auto left  = dynamic_cast<MultiSymbol*>((*body)[0]);
+    auto right = body->size() == 3 ? dynamic_cast<MultiSymbol*>((*body)[2]) : nullptr;
+    Constant a;
+    Constant b;
+    if (left == nullptr or right == nullptr or left->tag != "expression" or right->tag != "expression" or
+        not evaluate(left, a) or not evaluate(right, b))
+    {
+        return false;
+    }
+    auto op = operatorText((*body)[1]);
+    if      (op == "<")  result = a.number() <  b.number();
+    else if (op == ">")  result = a.number() >  b.number();
+    else if (op == "<=") result = a.number() <= b.number();
+    else if (op == ">=") result = a.number() >= b.number();
+    else if (op == "==") result = a.number() == b.number();
+    else if (op == "!=") result = a.number() != b.number();
+    else return false;
+    return true;
+}
+
+/**
+ * Builds the value node of a constant, i.e. value(val=basevalue(val=7))
+ * @return nullptr if the constant would change when written out (reals are written with six decimals)
+ */
+Symbol* constantSymbol(const Constant& constant, Arena& arena)
+{
+    Symbol* leaf = nullptr;
+    if (constant.integral)
+    {
+        leaf = arena.make<Integer>(constant.integer);
+    }
+    else if (std::stod(std::to_string(constant.real)) == constant.real)
+    {
+        leaf = arena.make<Double>(constant.real);
+    }
+    else
+    {
+        return nullptr;
+    }
+    MultiSymbolTable basevalue_table;
+    basevalue_table["val"] = SymbolList({leaf});
+    MultiSymbolTable value_table;
+    value_table["val"] = SymbolList({arena.make<MultiSymbol>("basevalue", basevalue_table)});
+    return arena.make<MultiSymbol>("value", value_table);
+}
+
+}
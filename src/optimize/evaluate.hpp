@@ -0,0 +1,33 @@
+/// Copyright 2017 Lucas Saldyt
+#pragma once
+#include "../syntax/symbols/export.hpp"
+
+namespace optimize
+{
+using namespace syntax;
+
+/**
+ * The value of a numeric literal, or of an expression made only of them
+ */
+struct Constant
+{
+    bool   integral = true;
+    int    integer  = 0;
+    double real     = 0.;
+
+    double number() const;
+    string text() const;
+};
+
+void postorder(string& tag, MultiSymbolTable& ms_table, const function<void(string&, MultiSymbolTable&)>& visitor);
+MultiSymbol* only(MultiSymbolTable& ms_table, const string& key, const string& tag);
+Symbol*      only(MultiSymbolTable& ms_table, const string& key);
+MultiSymbol* statementOf(Symbol* statement, const string& tag);
+
+bool constantValue(Symbol* value, Constant& result);
+bool evaluate(const SymbolList& body, size_t begin, size_t end, Constant& result);
+bool evaluate(MultiSymbol* expression, Constant& result);
+bool truth(MultiSymbol* boolexpression, bool& result);
+Symbol* constantSymbol(const Constant& constant, Arena& arena);
+
+}
@@ -0,0 +1,118 @@
+/// Copyright 2017 Lucas Saldyt
+#include "passes.hpp"
+#include "evaluate.hpp"
+
+namespace optimize
+{
+
+namespace
+{
+    /// Values of an expression body joined by * or /, which bind tighter than the + or - around them
+    struct Term
+    {
+        size_t begin;
+        size_t end;
+        bool constant;
+        Constant value;
+    };
+
+    vector<Term> terms(const SymbolList& body)
+    {
+        vector<Term> found;
+        size_t begin = 0;
+        for (size_t i = 1; i <= body.size(); i += 2)
+        {
+            bool additive = false;
+            if (i < body.size())
+            {
+                auto op = dynamic_cast<StringLiteral*>(body[i]);
+                additive = op != nullptr and (op->value == "+" or op->value == "-");
+            }
+            if (i == body.size() or additive)
+            {
+                Term term{begin, i, false, Constant()};
+                term.constant = evaluate(body, begin, i, term.value);
+                found.push_back(term);
+                begin = i + 1;
+            }
+        }
+        return found;
+    }
+}
+
+/**
+ * Replaces the constant parts of expressions with their values, i.e. 2 * 3 + 1 to 7, x - 2 * 3 to x - 6, 1 + 2 + x to 3 + x
+ * A part is folded only when every output language computes the same value for it: integer division and anything that
+ * overflows an int are left alone, and so are expressions with operators other than + - * /
+ */
+int foldConstants(IdentifiedGroup& identified_group, Arena& arena, OutputManager logger)
+{
+    int changes = 0;
+    postorder(get<0>(identified_group), get<1>(identified_group), [&](string& tag, MultiSymbolTable& ms_table)
+    {
+        static const int body_id = intern("body");
+        auto body = ms_table.find(body_id);
+        if (tag != "expression" or body == nullptr or body->size() < 3 or body->size() % 2 == 0)
+        {
+            return;
+        }
+        for (size_t i = 1; i < body->size(); i += 2)
+        {
+            auto op = dynamic_cast<StringLiteral*>((*body)[i]);
+            if (op == nullptr or (op->value != "+" and op->value != "-" and op->value != "*" and op->value != "/"))
+            {
+                return;
+            }
+        }
+        auto found = terms(*body);
+
+        // Leading constant terms are added up first, so they fold together
+        size_t prefix = 0;
+        while (prefix < found.size() and found[prefix].constant)
+        {
+            prefix++;
+        }
+        Constant leading;
+        Symbol* leading_symbol = nullptr;
+        if (prefix > 1 and evaluate(*body, 0, found[prefix - 1].end, leading))
+        {
+            leading_symbol = constantSymbol(leading, arena);
+        }
+
+        SymbolList folded;
+        size_t first = 0;
+        if (leading_symbol != nullptr)
+        {
+            folded.push_back(leading_symbol);
+            logger.log("constant-folding: folded " + std::to_string((found[prefix - 1].end + 1) / 2) + " values into " + leading.text(), 2);
+            first = prefix;
+        }
+        for (size_t t = first; t < found.size(); t++)
+        {
+            const auto& term = found[t];
+            if (t > 0)
+            {
+                folded.push_back((*body)[term.begin - 1]);
+            }
+            auto symbol = term.constant and term.end - term.begin > 1 ? constantSymbol(term.value, arena) : nullptr;
+            if (symbol != nullptr)
+            {
+                folded.push_back(symbol);
+                logger.log("constant-folding: folded " + std::to_string((term.end - term.begin + 1) / 2) + " values into " + term.value.text(), 2);
+                continue;
+            }
+            for (size_t i = term.begin; i < term.end; i++)
+            {
+                folded.push_back((*body)[i]);
+            }
+        }
+        if (folded.size() != body->size())
+        {
+            *body = folded;
+            changes++;
+        }
+    });
+    return changes;
+}
+
+}
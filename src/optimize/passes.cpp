@@ -0,0 +1,99 @@
+/// Copyright 2017 Lucas Saldyt
+#include "passes.hpp"
+
+namespace optimize
+{
+
+/**
+ * @param names Names of the passes to run, in order, see passMap and filePassMap
+ */
+PassManager::PassManager(vector<string> names)
+{
+    for (auto name : names)
+    {
+        if (contains(filePassMap, name))
+        {
+            passes.push_back(make_tuple(name, filePassMap.at(name), true));
+        }
+        else if (contains(passMap, name))
+        {
+            auto pass = passMap.at(name);
+            passes.push_back(make_tuple(name, [pass](IdentifiedGroups& identified_groups, Arena& arena, OutputManager logger)
+            {
+                int changes = 0;
+                for (auto& id_group : identified_groups)
+                {
+                    changes += pass(id_group, arena, logger);
+                }
+                return changes;
+            }, false));
+        }
+        else
+        {
+            string known;
+            for (auto kv : passMap)
+            {
+                known += " " + kv.first;
+            }
+            for (auto kv : filePassMap)
+            {
+                known += " " + kv.first;
+            }
+            throw named_exception("Unknown pass: " + name + " (known passes:" + known + ")");
+        }
+    }
+}
+
+/**
+ * Runs each pass over every group, before the next pass starts, and logs how many changes it made
+ */
+void PassManager::operator()(IdentifiedGroups& identified_groups, Arena& arena, OutputManager logger)
+{
+    for (auto& pass : passes)
+    {
+        int changes = get<1>(pass)(identified_groups, arena, logger);
+        logger.log("Pass " + get<0>(pass) + " made " + std::to_string(changes) + " changes");
+    }
+}
+
+/**
+ * Runs each pass over a single group, i.e. one statement of a streamed file
+ * Passes that need the whole file can't run this way (see needsWholeFile)
+ */
+void PassManager::operator()(IdentifiedGroup& identified_group, Arena& arena, OutputManager logger)
+{
+    for (auto& pass : passes)
+    {
+        if (get<2>(pass))
+        {
+            throw named_exception("Pass " + get<0>(pass) + " needs every group of a file at once");
+        }
+        IdentifiedGroups identified_groups;
+        identified_groups.push_back(std::move(identified_group));
+        int changes = get<1>(pass)(identified_groups, arena, logger);
+        identified_group = std::move(identified_groups[0]);
+        logger.log("Pass " + get<0>(pass) + " made " + std::to_string(changes) + " changes");
+    }
+}
+
+bool PassManager::empty() const
+{
+    return passes.empty();
+}
+
+/**
+ * @return Whether any pass needs to see every group of a file at once, which rules out compiling it one group at a time
+ */
+bool PassManager::needsWholeFile() const
+{
+    for (auto& pass : passes)
+    {
+        if (get<2>(pass))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
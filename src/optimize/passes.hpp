@@ -0,0 +1,58 @@
+/// Copyright 2017 Lucas Saldyt
+#pragma once
+#include "../grammar/grammar.hpp"
+
+/**
+ * Optimization passes over the universal AST, run between the pre_ and post_transformers
+ * i.e. --passes=constant-folding,dead-branches,unused-assignments,type-inference,signature-inference
+ */
+namespace optimize
+{
+using namespace grammar;
+
+/**
+ * Rewrites one top-level group of a universal AST in place
+ * Logs each change it makes, and returns how many it made
+ */
+using Pass = function<int(IdentifiedGroup&, Arena&, OutputManager)>;
+
+/**
+ * Rewrites every top-level group of a file at once, for passes that need to see how groups use each other
+ */
+using FilePass = function<int(IdentifiedGroups&, Arena&, OutputManager)>;
+
+int foldConstants(IdentifiedGroup& identified_group, Arena& arena, OutputManager logger);
+int removeDeadBranches(IdentifiedGroup& identified_group, Arena& arena, OutputManager logger);
+int removeUnusedAssignments(IdentifiedGroup& identified_group, Arena& arena, OutputManager logger);
+int inferTypes(IdentifiedGroup& identified_group, Arena& arena, OutputManager logger);
+int inferSignatures(IdentifiedGroups& identified_groups, Arena& arena, OutputManager logger);
+
+const unordered_map<string, Pass> passMap = {
+    {"constant-folding",   foldConstants},
+    {"dead-branches",      removeDeadBranches},
+    {"unused-assignments", removeUnusedAssignments},
+    {"type-inference",     inferTypes}
+};
+
+const unordered_map<string, FilePass> filePassMap = {
+    {"signature-inference", inferSignatures}
+};
+
+/**
+ * Runs a list of passes, in order, over each AST it is given
+ */
+class PassManager
+{
+public:
+    PassManager(vector<string> names={});
+
+    void operator()(IdentifiedGroups& identified_groups, Arena& arena, OutputManager logger);
+    void operator()(IdentifiedGroup& identified_group, Arena& arena, OutputManager logger);
+    bool empty() const;
+    bool needsWholeFile() const;
+
+private:
+    vector<tuple<string, FilePass, bool>> passes; // Name, pass, and whether it needs the whole file
+};
+
+}
@@ -0,0 +1,737 @@
+/// Copyright 2017 Lucas Saldyt
+#include "passes.hpp"
+#include "evaluate.hpp"
+
+namespace optimize
+{
+
+namespace
+{
+    // Types are "" while nothing is known about them yet, "?" once they can't be proven,
+    // or the universal name of a type, which output languages spell their own way: int, float or bool
+    const string unknown = "?";
+
+    /// Type that holds values of both types, the way C-like targets convert them
+    string join(const string& a, const string& b)
+    {
+        if (a.empty() or a == b)
+        {
+            return b;
+        }
+        if (b.empty())
+        {
+            return a;
+        }
+        return (a == "int" and b == "float") or (a == "float" and b == "int") ? "float" : unknown;
+    }
+
+    /// Type of a parameter passed arguments of both types, which have to be the same: converting an int to float changes the result
+    string unify(const string& a, const string& b)
+    {
+        return a.empty() or a == b ? b : b.empty() ? a : unknown;
+    }
+
+    /// Text of an operator or other punctuation leaf, or "" for any other symbol
+    string operatorText(Symbol* symbol)
+    {
+        auto literal = dynamic_cast<StringLiteral*>(symbol);
+        return literal == nullptr or dynamic_cast<Identifier*>(symbol) != nullptr ? "" : literal->value;
+    }
+
+    /// Node under a chain of nodes that each only wrap it, i.e. the value of boolexpression(expression(value)), or symbol itself
+    Symbol* unwrap(Symbol* symbol)
+    {
+        const unordered_set<string> wrappers = {"boolexpression", "expression", "value", "basevalue", "lvalue", "parenexpr"};
+        auto multi = dynamic_cast<MultiSymbol*>(symbol);
+        while (multi != nullptr and contains(wrappers, multi->tag) and multi->table.size() == 1)
+        {
+            const auto& children = (*multi->table.begin()).second;
+            if (children.size() != 1)
+            {
+                break;
+            }
+            symbol = children[0];
+            multi  = dynamic_cast<MultiSymbol*>(symbol);
+        }
+        return symbol;
+    }
+
+    /// Name a value consists of alone, i.e. x in print(x), or ""
+    string nameOf(Symbol* symbol)
+    {
+        auto identifier = dynamic_cast<Identifier*>(unwrap(symbol));
+        return identifier == nullptr ? "" : identifier->value;
+    }
+
+    /// Name of the function a call calls, or "" if it isn't a plain call
+    string calleeOf(Symbol* symbol)
+    {
+        auto call = dynamic_cast<MultiSymbol*>(unwrap(symbol));
+        if (call == nullptr or call->tag != "functioncall")
+        {
+            return "";
+        }
+        auto identifier = dynamic_cast<Identifier*>(only(call->table, "identifier"));
+        return identifier == nullptr ? "" : identifier->value;
+    }
+
+    /// A local variable of a function, and everything it is assigned
+    struct Variable
+    {
+        bool excluded   = false; // Parameters and loop variables, whose types come from elsewhere
+        bool parameter  = false; // Parameters whose callers are all known, so they have the type of what they are called with
+        string declared;         // For those, the type they are called with
+        int  uses       = 0;     // Appearances of the name anywhere in the function
+        int  known_uses = 0;     // Appearances that can't change what it holds: assignments, appends, indexing, iteration, len and print
+        Symbol* first   = nullptr;        // Value of its first assignment, which fixes its type in C-like targets (i.e. auto)
+        string  iterated;                 // For loop variables, the list they go over, or "range"
+        vector<MultiSymbol*> literals;    // List literals assigned to it
+        vector<Symbol*>      assigned;    // Other values assigned to it
+        vector<Symbol*>      elements;    // Values put into it as a list: elements of its literals, and appended values
+        string type;                      // Type of the variable, or of its elements if it is a list
+    };
+
+    /**
+     * Infers the types of the local variables of one function
+     * Scalars get the type of the value they are first assigned, and lists, which are variables only ever assigned list
+     * literals, the type that holds every element they are given. Values are typed by literals, variables, indexing,
+     * and arithmetic, the way C-like targets type them
+     */
+    class TypeInference
+    {
+    public:
+        /**
+         * @param function_table Arguments and body of the function
+         * @param parameters     Types of the parameters that are known, from the calls to the function
+         * @param set_returns    Types returned by the functions of the file that are known, or void
+         */
+        TypeInference(MultiSymbolTable& function_table, const unordered_map<string, string>& parameters={},
+                      const unordered_map<string, string>& set_returns={}) :
+            returns(set_returns)
+        {
+            static const int args_id = intern("args");
+            auto args = function_table.find(args_id);
+            for (auto arg : args == nullptr ? SymbolList() : *args)
+            {
+                auto name = nameOf(arg);
+                if (not name.empty())
+                {
+                    variables[name].excluded = true;
+                    variables[name].parameter = contains(parameters, name);
+                    variables[name].declared  = variables[name].parameter ? parameters.at(name) : unknown;
+                }
+            }
+            for (auto kv : function_table)
+            {
+                for (auto symbol : kv.second)
+                {
+                    collect(symbol);
+                }
+            }
+            solve();
+        }
+
+        /**
+         * Gives every list literal assigned to a list of ints or floats the type of its elements, as an elementtype entry
+         * Lists of bools are left alone, since C++ packs std::vector<bool> and can't hand out references to its elements
+         * @return Number of literals typed
+         */
+        int annotate(Arena& arena, const string& function, OutputManager logger)
+        {
+            int changes = 0;
+            for (auto& kv : variables)
+            {
+                auto& variable = kv.second;
+                if (variable.literals.empty() or not variable.assigned.empty() or variable.excluded or
+                    variable.uses != variable.known_uses or (variable.type != "int" and variable.type != "float"))
+                {
+                    continue;
+                }
+                for (auto literal : variable.literals)
+                {
+                    literal->table["elementtype"] = SymbolList({arena.make<Identifier>(variable.type)});
+                }
+                logger.log("type-inference: " + kv.first + " is a list of " + variable.type + " in " + function, 2);
+                changes += variable.literals.size();
+            }
+            return changes;
+        }
+
+        /**
+         * @return Type every return statement returns, void if none return a value, or "?" if some do and some don't
+         */
+        string returnType()
+        {
+            string type;
+            int values = 0;
+            for (auto value : returned)
+            {
+                if (value != nullptr)
+                {
+                    type = join(type, typeOf(value));
+                    values++;
+                }
+            }
+            if (values == 0)
+            {
+                return "void";
+            }
+            return values == static_cast<int>(returned.size()) ? type : unknown;
+        }
+
+        /// Type of a value, given the types of the variables found so far
+        string typeOf(Symbol* symbol)
+        {
+            symbol = unwrap(symbol);
+            if (dynamic_cast<Integer*>(symbol) != nullptr)
+            {
+                return "int";
+            }
+            if (dynamic_cast<Double*>(symbol) != nullptr)
+            {
+                return "float";
+            }
+            if (auto identifier = dynamic_cast<Identifier*>(symbol))
+            {
+                // Symbol tables may have converted True to true
+                const unordered_set<string> booleans = {"True", "False", "true", "false"};
+                if (contains(booleans, identifier->value))
+                {
+                    return "bool";
+                }
+                auto found = variables.find(identifier->value);
+                bool scalar = found != variables.end() and found->second.literals.empty() and
+                              (found->second.parameter or found->second.first != nullptr or not found->second.iterated.empty());
+                return scalar ? found->second.type : unknown;
+            }
+            auto multi = dynamic_cast<MultiSymbol*>(symbol);
+            if (multi == nullptr)
+            {
+                return unknown;
+            }
+            if (multi->tag == "elementaccess")
+            {
+                auto found = variables.find(nameOf(only(multi->table, "val")));
+                return found == variables.end() or found->second.literals.empty() ? unknown : found->second.type;
+            }
+            if (multi->tag == "functioncall")
+            {
+                auto found = returns.find(calleeOf(multi));
+                return found == returns.end() or found->second == "void" ? unknown : found->second;
+            }
+            static const int body_id = intern("body");
+            auto body = multi->table.find(body_id);
+            if (body == nullptr or (multi->tag != "expression" and multi->tag != "boolexpression"))
+            {
+                return unknown;
+            }
+            return typeOf(*body);
+        }
+
+    private:
+        unordered_map<string, Variable> variables;
+        unordered_map<string, string> returns;
+        vector<Symbol*> returned; // Values of the function's return statements, nullptr for those without one
+
+        /// Counts a name that appears in a place that can't change the type of what it holds
+        void known(const string& name)
+        {
+            if (not name.empty())
+            {
+                variables[name].known_uses++;
+            }
+        }
+
+        /// Records the assignments, appends and loops under a symbol, and counts every name in it
+        void collect(Symbol* symbol)
+        {
+            if (auto identifier = dynamic_cast<Identifier*>(symbol))
+            {
+                variables[identifier->value].uses++;
+                return;
+            }
+            auto multi = dynamic_cast<MultiSymbol*>(symbol);
+            if (multi == nullptr)
+            {
+                return;
+            }
+            const unordered_set<string> definitions = {"function", "memberfunction", "lambda", "class"};
+            if (contains(definitions, multi->tag))
+            {
+                countNames(multi); // Names used by nested definitions escape the function, so their uses stay unknown
+                return;
+            }
+            record(multi);
+            for (auto kv : multi->table)
+            {
+                for (auto child : kv.second)
+                {
+                    collect(child);
+                }
+            }
+        }
+
+        void countNames(MultiSymbol* multi)
+        {
+            for (auto kv : multi->table)
+            {
+                for (auto child : kv.second)
+                {
+                    if (auto identifier = dynamic_cast<Identifier*>(child))
+                    {
+                        variables[identifier->value].uses++;
+                    }
+                    else if (auto nested = dynamic_cast<MultiSymbol*>(child))
+                    {
+                        countNames(nested);
+                    }
+                }
+            }
+        }
+
+        void record(MultiSymbol* multi)
+        {
+            auto& table = multi->table;
+            if (multi->tag == "assignment")
+            {
+                auto name = dynamic_cast<Identifier*>(only(table, "lval"));
+                auto rval = only(table, "rval");
+                auto item = dynamic_cast<MultiSymbol*>(only(table, "lval"));
+                if (item != nullptr and item->tag == "elementaccess" and rval != nullptr)
+                {
+                    // i.e. x[i] = v, which puts v into x. The name is counted as a known use with the elementaccess
+                    variables[nameOf(only(item->table, "val"))].elements.push_back(rval);
+                    return;
+                }
+                if (name == nullptr or rval == nullptr or operatorText(only(table, "op")) != "=")
+                {
+                    return;
+                }
+                auto& variable = variables[name->value];
+                known(name->value);
+                variable.first = variable.first == nullptr ? rval : variable.first;
+                auto literal = dynamic_cast<MultiSymbol*>(unwrap(rval));
+                if (literal == nullptr or literal->tag != "vector")
+                {
+                    variable.assigned.push_back(rval);
+                    return;
+                }
+                variable.literals.push_back(literal);
+                static const int values_id = intern("values");
+                auto values = literal->table.find(values_id);
+                for (auto value : values == nullptr ? SymbolList() : *values)
+                {
+                    variable.elements.push_back(value);
+                }
+            }
+            else if (multi->tag == "memberaccess")
+            {
+                // i.e. x.append(v), where symbol tables may have converted append to push_back
+                auto name   = nameOf(only(table, "access"));
+                auto member = dynamic_cast<MultiSymbol*>(only(table, "member"));
+                auto callee = calleeOf(member);
+                static const int args_id = intern("args");
+                auto args   = member == nullptr ? nullptr : member->table.find(args_id);
+                if (not name.empty() and (callee == "append" or callee == "push_back") and args != nullptr and args->size() == 1)
+                {
+                    known(name);
+                    variables[name].elements.push_back((*args)[0]);
+                }
+            }
+            else if (multi->tag == "forloop")
+            {
+                auto loopvar = dynamic_cast<Identifier*>(only(table, "loopvar"));
+                auto loopexpr = only(table, "loopexpr");
+                if (loopvar == nullptr or loopexpr == nullptr)
+                {
+                    return;
+                }
+                auto& variable = variables[loopvar->value];
+                variable.excluded = true;
+                if (calleeOf(loopexpr) == "range")
+                {
+                    variable.iterated = "range";
+                }
+                else if (not nameOf(loopexpr).empty())
+                {
+                    variable.iterated = nameOf(loopexpr);
+                    known(variable.iterated);
+                }
+            }
+            else if (multi->tag == "elementaccess")
+            {
+                known(nameOf(only(table, "val")));
+            }
+            else if (multi->tag == "return")
+            {
+                returned.push_back(only(table, "expression"));
+            }
+            else if (multi->tag == "functioncall")
+            {
+                auto callee = calleeOf(multi);
+                static const int args_id = intern("args");
+                auto args   = table.find(args_id);
+                if ((callee == "len" or callee == "print") and args != nullptr)
+                {
+                    for (auto arg : *args)
+                    {
+                        known(nameOf(arg));
+                    }
+                }
+            }
+        }
+
+        /// Type of the body of an expression: operands alternating with operators
+        string typeOf(const SymbolList& body)
+        {
+            const unordered_set<string> comparisons = {"<", ">", "<=", ">=", "==", "!=", "and", "or", "not", "&&", "||", "!"};
+            string type;
+            bool divides = false;
+            bool modulo  = false;
+            for (auto symbol : body)
+            {
+                auto op = operatorText(symbol);
+                if (contains(comparisons, op))
+                {
+                    return "bool";
+                }
+                if (op == "+" or op == "-" or op == "*" or op == "/" or op == "%")
+                {
+                    divides = divides or op == "/";
+                    modulo  = modulo  or op == "%";
+                    continue;
+                }
+                if (not op.empty())
+                {
+                    return unknown;
+                }
+                type = join(type, typeOf(symbol));
+            }
+            if (type == "bool" and body.size() > 1)
+            {
+                return unknown;
+            }
+            if (divides and type == "int") // Truncates in C-like targets, but gives a float in python3
+            {
+                return unknown;
+            }
+            return modulo and type == "float" ? unknown : type;
+        }
+
+        /// Recomputes every variable's type from the others' until none change
+        void solve()
+        {
+            for (size_t round = 0; round <= variables.size() + 1; round++)
+            {
+                bool changed = false;
+                for (auto& kv : variables)
+                {
+                    auto& variable = kv.second;
+                    string type;
+                    if (variable.parameter)
+                    {
+                        // Assigning a parameter a value of another type would convert the value in C-like targets
+                        type = variable.declared;
+                        for (auto value : variable.assigned)
+                        {
+                            type = type.empty() or join(type, typeOf(value)) == type ? type : unknown;
+                        }
+                        type = variable.literals.empty() ? type : unknown;
+                    }
+                    else if (variable.iterated == "range")
+                    {
+                        type = "int";
+                    }
+                    else if (not variable.iterated.empty())
+                    {
+                        auto found = variables.find(variable.iterated);
+                        type = found == variables.end() or found->second.literals.empty() ? unknown : found->second.type;
+                    }
+                    else if (not variable.literals.empty())
+                    {
+                        for (auto element : variable.elements)
+                        {
+                            type = join(type, typeOf(element));
+                        }
+                    }
+                    else if (variable.first != nullptr)
+                    {
+                        type = typeOf(variable.first);
+                    }
+                    changed = changed or type != variable.type;
+                    variable.type = type;
+                }
+                if (not changed)
+                {
+                    return;
+                }
+            }
+            for (auto& kv : variables) // Types that never settle aren't proven
+            {
+                kv.second.type = unknown;
+            }
+        }
+    };
+
+    /// Node a top-level group consists of, i.e. the function in statement(function), or nullptr if it isn't a single node
+    MultiSymbol* definitionOf(MultiSymbolTable& group_table)
+    {
+        if (group_table.size() != 1 or (*group_table.begin()).second.size() != 1)
+        {
+            return nullptr;
+        }
+        return dynamic_cast<MultiSymbol*>((*group_table.begin()).second[0]);
+    }
+
+    /// Arguments and body of a function, which are all TypeInference needs from it
+    MultiSymbolTable functionScope(MultiSymbolTable& ms_table)
+    {
+        MultiSymbolTable scope;
+        static const int args_id = intern("args");
+        auto args = ms_table.find(args_id);
+        scope["args"] = args == nullptr ? SymbolList() : *args;
+        static const int body_id = intern("body");
+        auto statements = ms_table.find(body_id);
+        scope["body"] = statements == nullptr ? SymbolList() : *statements;
+        return scope;
+    }
+
+    /// A top-level function, and what the calls to it in its file show about its signature
+    struct Signature
+    {
+        MultiSymbolTable* definition = nullptr;
+        SymbolList     parameters;
+        vector<string> types;   // Type of each parameter: what every call passes it, joined
+        string returns;         // Type of what it returns, or void
+        int  calls = 0;
+        bool typed = true;      // Whether it is only ever called, with one argument per parameter
+    };
+
+    /// A top-level group, and the calls it makes to the functions of its file
+    struct Scope
+    {
+        MultiSymbolTable table;
+        string function; // Name of the function the group defines, if it has a Signature
+        vector<tuple<MultiSymbol*, bool>> calls; // Each call, and whether it is in a nested definition, where its arguments can't be typed
+    };
+
+    /// Finds the calls to functions with signatures under a symbol, and counts every name in it
+    void findCalls(Symbol* symbol, bool nested, unordered_map<string, Signature>& signatures, Scope& scope, unordered_map<string, int>& uses)
+    {
+        if (auto identifier = dynamic_cast<Identifier*>(symbol))
+        {
+            uses[identifier->value]++;
+            return;
+        }
+        auto multi = dynamic_cast<MultiSymbol*>(symbol);
+        if (multi == nullptr)
+        {
+            return;
+        }
+        const unordered_set<string> definitions = {"function", "memberfunction", "lambda", "class"};
+        nested = nested or contains(definitions, multi->tag);
+        auto signature = signatures.find(calleeOf(multi));
+        if (multi->tag == "functioncall" and signature != signatures.end())
+        {
+            scope.calls.push_back(make_tuple(multi, nested));
+            signature->second.calls++;
+        }
+        for (auto kv : multi->table)
+        {
+            for (auto child : kv.second)
+            {
+                findCalls(child, nested, signatures, scope, uses);
+            }
+        }
+    }
+
+    /// Names C-like targets have for the types a signature can have
+    MultiSymbol* scalarType(Arena& arena, const string& type)
+    {
+        MultiSymbolTable table;
+        table["name"] = SymbolList({arena.make<Identifier>(type)});
+        return arena.make<MultiSymbol>("scalartype", table);
+    }
+}
+
+/**
+ * Infers the element types of the lists that functions build, so C-like targets can declare them with concrete types
+ * (i.e. std::vector<int> instead of std::vector<Object>), and marks each list literal of a typed list with an elementtype
+ * A list is only typed if every assignment to it is a list literal, and it is only used in ways that can't put values of
+ * other types into it: appending values of known types, indexing, iterating over it, and calling len or print on it.
+ * Anything else, like passing it to another function or using it in a nested function, leaves it untyped
+ */
+int inferTypes(IdentifiedGroup& identified_group, Arena& arena, OutputManager logger)
+{
+    int changes = 0;
+    postorder(get<0>(identified_group), get<1>(identified_group), [&](string& tag, MultiSymbolTable& ms_table)
+    {
+        if (tag != "function" and tag != "memberfunction")
+        {
+            return;
+        }
+        auto identifier = dynamic_cast<Identifier*>(only(ms_table, "identifier"));
+        string function = identifier == nullptr ? tag : identifier->value;
+        auto scope = functionScope(ms_table);
+        changes += TypeInference(scope).annotate(arena, function, logger);
+    });
+    return changes;
+}
+
+/**
+ * Infers the signatures of the top-level functions of a file from the calls to them, so C-like targets can declare
+ * them with concrete types (i.e. int fib(int n) instead of a template), and marks each one that has a single signature
+ * with params, a declaration per parameter, and a returntype.
+ * A function gets a signature if its name is only ever used to call it with one argument per parameter, every argument
+ * it is passed has the same type as the others in its place, and every value it returns has the same type (or int and
+ * float, which join to float) as the others. Functions called with different types stay templates. Calls from other
+ * functions are typed with those functions' signatures, so signatures are recomputed until none change, which also
+ * types recursive calls
+ * @return Number of functions given a signature
+ */
+int inferSignatures(IdentifiedGroups& identified_groups, Arena& arena, OutputManager logger)
+{
+    unordered_map<string, Signature> signatures;
+    vector<string> order;
+    vector<Scope> scopes;
+    for (auto& id_group : identified_groups)
+    {
+        auto definition = definitionOf(get<1>(id_group));
+        bool function   = definition != nullptr and definition->tag == "function";
+        auto& table     = function ? definition->table : get<1>(id_group);
+        Scope scope;
+        scope.table = function ? functionScope(table) : table;
+        auto identifier = dynamic_cast<Identifier*>(only(table, "identifier"));
+        if (function and identifier != nullptr)
+        {
+            bool redefined = contains(signatures, identifier->value);
+            auto& signature = signatures[identifier->value];
+            signature.definition = &table;
+            signature.parameters = scope.table["args"];
+            signature.types      = vector<string>(signature.parameters.size());
+            for (auto parameter : signature.parameters)
+            {
+                signature.typed = signature.typed and dynamic_cast<Identifier*>(parameter) != nullptr;
+            }
+            signature.typed = signature.typed and not redefined;
+            scope.function  = identifier->value;
+            if (not redefined)
+            {
+                order.push_back(identifier->value);
+            }
+        }
+        scopes.push_back(scope);
+    }
+
+    unordered_map<string, int> uses;
+    for (auto& scope : scopes)
+    {
+        for (auto kv : scope.table)
+        {
+            for (auto symbol : kv.second)
+            {
+                findCalls(symbol, false, signatures, scope, uses);
+            }
+        }
+    }
+    for (auto& kv : signatures)
+    {
+        kv.second.typed = kv.second.typed and uses[kv.first] == kv.second.calls;
+    }
+
+    // Every round types each call with the signatures of the last, starting from nothing known
+    unordered_map<string, string> returns;
+    for (const auto& name : order)
+    {
+        returns[name] = "";
+    }
+    bool settled = false;
+    for (size_t round = 0; round <= 4 * (signatures.size() + uses.size()) and not settled; round++)
+    {
+        settled = true;
+        unordered_map<string, vector<string>> types;
+        for (auto& kv : signatures)
+        {
+            types[kv.first] = vector<string>(kv.second.parameters.size());
+        }
+        unordered_map<string, string> next_returns;
+        for (auto& scope : scopes)
+        {
+            unordered_map<string, string> parameters;
+            if (not scope.function.empty())
+            {
+                auto& signature = signatures[scope.function];
+                for (size_t i = 0; i < signature.parameters.size(); i++)
+                {
+                    parameters[nameOf(signature.parameters[i])] = signature.types[i];
+                }
+            }
+            TypeInference inference(scope.table, parameters, returns);
+            for (auto& call : scope.calls)
+            {
+                auto callee     = calleeOf(get<0>(call));
+                auto& signature = signatures[callee];
+                static const int args_id = intern("args");
+                auto args       = get<0>(call)->table.find(args_id);
+                auto arg_list   = args == nullptr ? SymbolList() : *args;
+                if (arg_list.size() != signature.parameters.size())
+                {
+                    signature.typed = false;
+                    continue;
+                }
+                for (size_t i = 0; i < arg_list.size(); i++)
+                {
+                    types[callee][i] = unify(types[callee][i], get<1>(call) ? unknown : inference.typeOf(arg_list[i]));
+                }
+            }
+            if (not scope.function.empty())
+            {
+                next_returns[scope.function] = inference.returnType();
+            }
+        }
+        for (auto& kv : signatures)
+        {
+            settled = settled and kv.second.types == types[kv.first] and returns[kv.first] == next_returns[kv.first];
+            kv.second.types   = types[kv.first];
+            kv.second.returns = next_returns[kv.first];
+        }
+        returns = next_returns;
+    }
+    if (not settled)
+    {
+        return 0;
+    }
+
+    int changes = 0;
+    const unordered_set<string> scalars = {"int", "float", "bool"};
+    for (const auto& name : order)
+    {
+        auto& signature = signatures[name];
+        bool concrete = signature.typed and (signature.returns == "void" or contains(scalars, signature.returns));
+        for (const auto& type : signature.types)
+        {
+            concrete = concrete and contains(scalars, type);
+        }
+        if (not concrete)
+        {
+            continue;
+        }
+        SymbolList declarations;
+        string text;
+        for (size_t i = 0; i < signature.parameters.size(); i++)
+        {
+            MultiSymbolTable declaration;
+            declaration["type"]       = SymbolList({scalarType(arena, signature.types[i])});
+            declaration["identifier"] = SymbolList({signature.parameters[i]});
+            declarations.push_back(arena.make<MultiSymbol>("declaration", declaration));
+            text += (i == 0 ? "" : ", ") + signature.types[i] + " " + nameOf(signature.parameters[i]);
+        }
+        (*signature.definition)["params"]     = declarations;
+        (*signature.definition)["returntype"] = SymbolList({scalarType(arena, signature.returns)});
+        logger.log("signature-inference: " + signature.returns + " " + name + "(" + text + ")", 2);
+        changes++;
+    }
+    return changes;
+}
+
+}
@@ -0,0 +1,59 @@
+/// Copyright 2017 Lucas Saldyt
+#include "budget.hpp"
+
+namespace parse
+{
+    budget_exceeded::budget_exceeded(string set_rule, int set_line, string set_reason) :
+        named_exception("Parse budget exceeded (" + set_reason + ") in rule \"" + set_rule + "\" on line " + std::to_string(set_line)),
+        rule(set_rule),
+        line(set_line)
+    {
+    }
+
+    ParseBudget::ParseBudget(long set_max_steps, double set_max_seconds) :
+        max_steps(set_max_steps),
+        max_seconds(set_max_seconds)
+    {
+        reset();
+    }
+
+    /// Start counting again, i.e. at the beginning of a new file
+    void ParseBudget::reset()
+    {
+        step_count = 0;
+        start_time = getTime();
+    }
+
+    /**
+     * Record a single matcher invocation
+     * @param rule Grammar rule being matched
+     * @param line Source line of the first remaining token
+     */
+    void ParseBudget::step(const string& rule, int line)
+    {
+        step_count++;
+        if (max_steps > 0 and step_count > max_steps)
+        {
+            throw budget_exceeded(rule, line, std::to_string(max_steps) + " steps");
+        }
+        // Reading the clock is comparatively expensive, so only do it every so often
+        if (max_seconds > 0. and step_count % 256 == 0)
+        {
+            double elapsed = (double)(getTime() - start_time) / 1000000.;
+            if (elapsed > max_seconds)
+            {
+                throw budget_exceeded(rule, line, std::to_string(max_seconds) + "s");
+            }
+        }
+    }
+
+    long ParseBudget::steps() const
+    {
+        return step_count;
+    }
+
+    bool ParseBudget::limited() const
+    {
+        return max_steps > 0 or max_seconds > 0.;
+    }
+}
@@ -0,0 +1,46 @@
+/// Copyright 2017 Lucas Saldyt
+#pragma once
+#include "../tools/tools.hpp"
+
+namespace parse
+{
+    using namespace tools;
+
+    /**
+     * Thrown once a file has used up its parse budget
+     * Names the grammar rule and source line that were being matched when the budget ran out
+     */
+    class budget_exceeded : public named_exception
+    {
+    public:
+        budget_exceeded(string set_rule, int set_line, string set_reason);
+
+        string rule;
+        int    line;
+    };
+
+    /**
+     * Bounds the amount of backtracking done while identifying a single file
+     * Counts matcher invocations, checked on every step, and optionally wall time, checked every 256 steps,
+     * so a time limit can be overrun by up to 256 steps
+     * A limit of zero disables that check
+     */
+    class ParseBudget
+    {
+    public:
+        ParseBudget(long set_max_steps=0, double set_max_seconds=0.);
+
+        void reset();
+        void step(const string& rule, int line);
+
+        long steps() const;
+        bool limited() const;
+
+        long   max_steps;
+        double max_seconds;
+
+    private:
+        long step_count = 0;
+        unsigned long long start_time = 0;
+    };
+}
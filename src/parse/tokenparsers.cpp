@@ -1,33 +1,47 @@
 /// Copyright 2017 Lucas Saldyt
 #include "tokenparsers.hpp"
-#include "../syntax/symbols/export.hpp"
 
 namespace parse
 {
+    TokenResult::TokenResult(bool set_result, vector<SymbolicToken> set_consumed, int set_position) :
+        result(set_result),
+        consumed(set_consumed),
+        position(set_position)
+    {
+    }
+
     /**
      * Parses a symbolictoken by its sub type
-     * i.e. wildcard int 
+     * i.e. wildcard int
      */
     SymbolicTokenParser subTypeParser(string sub_type)
     {
-        const auto comparator = [sub_type](SymbolicToken token)
+        int sub_type_id = intern(sub_type);
+        return [sub_type_id](TokenStream& tokens, int position)
         {
-            return token.sub_type == sub_type;
+            if (position < tokens.size() and tokens.sub_types[position] == sub_type_id)
+            {
+                return TokenResult(true, {SymbolicToken(position, tokens.types[position])}, position + 1);
+            }
+            return TokenResult(false, {}, position);
         };
-        return singleTemplate<SymbolicToken>(comparator);
     }
 
     /**
      * Parses a symbolictoken by its type
-     * i.e. operator wildcard 
+     * i.e. operator wildcard
      */
     SymbolicTokenParser typeParser(string type)
     {
-        const auto comparator = [type](SymbolicToken token)
+        int type_id = intern(type);
+        return [type_id](TokenStream& tokens, int position)
         {
-            return token.type == type;
+            if (position < tokens.size() and tokens.types[position] == type_id)
+            {
+                return TokenResult(true, {SymbolicToken(position, type_id)}, position + 1);
+            }
+            return TokenResult(false, {}, position);
         };
-        return singleTemplate<SymbolicToken>(comparator);
     }
 
     /**
@@ -36,72 +50,126 @@ namespace parse
      */
     SymbolicTokenParser dualTypeParser(string type, string sub_type)
     {
-        return allOf<SymbolicToken>({typeParser(type), subTypeParser(sub_type)});
+        int type_id     = intern(type);
+        int sub_type_id = intern(sub_type);
+        return [type_id, sub_type_id](TokenStream& tokens, int position)
+        {
+            if (position < tokens.size() and
+                tokens.types[position] == type_id and
+                tokens.sub_types[position] == sub_type_id)
+            {
+                return TokenResult(true, {SymbolicToken(position, type_id)}, position + 1);
+            }
+            return TokenResult(false, {}, position);
+        };
     }
 
     /**
-     * Annotates all consumed tokens to be eventually discarded
+     * Run a list of parsers sequentially, passing only if all of them pass.
+     * Combines the consumed elements of all parsers
      */
-    SymbolicTokenParser
-    discard
-    (SymbolicTokenParser matcher)
+    SymbolicTokenParser inOrder(vector<SymbolicTokenParser> matchers)
     {
-        using syntax::Symbol;
-        return [matcher](vector<SymbolicToken> terms)
+        return [matchers](TokenStream& tokens, int original_position)
         {
-            auto result = matcher(terms);
-            for (auto& term : result.consumed)
+            vector<SymbolicToken> consumed;
+            int position = original_position;
+
+            for (auto& matcher : matchers)
+            {
+                auto result = matcher(tokens, position);
+                if (result.result)
+                {
+                    concat(consumed, result.consumed);
+                    position = result.position;
+                }
+                else
+                {
+                    return TokenResult(false, {}, original_position);
+                }
+            }
+            return TokenResult(true, consumed, position);
+        };
+    }
+
+    /**
+     * Attempt to parse any parser from a list of parsers, failing only if all of the parsers fail
+     * The first successful parser is used, unless a later one consumes more elements
+     */
+    SymbolicTokenParser anyOf(vector<SymbolicTokenParser> matchers)
+    {
+        return [matchers](TokenStream& tokens, int position)
+        {
+            auto result = TokenResult(false, {}, position);
+            for (auto& matcher : matchers)
             {
-                //print("Discarding token: " + term.type + ", " + term.sub_type);
-                term = SymbolicToken(make_shared<Symbol>(Symbol()), "discard", "discard", "");
+                auto match_result = matcher(tokens, position);
+                if ((match_result.result and match_result.consumed.size() > result.consumed.size())
+                     or not result.result)
+                {
+                    result = match_result;
+                }
             }
             return result;
         };
     }
 
     /**
-     * Removes discard-annotated tokens from vector of tokens
+     * Optionally match a parser. Never fails.
+     */
+    SymbolicTokenParser optional(SymbolicTokenParser matcher)
+    {
+        return [matcher](TokenStream& tokens, int position)
+        {
+            auto result = matcher(tokens, position);
+            result.result = true;
+            return result;
+        };
+    }
+
+    /**
+     * Annotates all consumed tokens to be eventually discarded
+     * Consumed elements are replaced by markers, so they still count towards anyOf's longest match
      */
-    vector<SymbolicToken>
-    clean
-    (const vector<SymbolicToken>& tokens)
+    SymbolicTokenParser
+    discard
+    (SymbolicTokenParser matcher)
     {
-        vector<SymbolicToken> clean_tokens;
-        clean_tokens.reserve(tokens.size());
-        for (auto t : tokens)
+        return [matcher](TokenStream& tokens, int position)
         {
-            if (t.type != "discard")
+            auto result = matcher(tokens, position);
+            for (auto& term : result.consumed)
             {
-                clean_tokens.push_back(t);
+                term.index = SymbolicToken::discarded;
+                term.value = nullptr;
             }
-        }
-        return clean_tokens;
+            return result;
+        };
     }
 
     /**
      * Version of many for seperating nested multi-token parsers. Unnestable
-     * Uses annotation to mark points between groups of consumed tokens
+     * Uses seperator markers between groups of consumed tokens
      */
     SymbolicTokenParser
     manySeperated
     (SymbolicTokenParser matcher, bool nonempty)
     {
-        using syntax::Symbol;
-        return [matcher, nonempty](vector<SymbolicToken> terms)
+        return [matcher, nonempty](TokenStream& tokens, int position)
         {
-            auto consumed = vector<SymbolicToken>(); 
+            auto consumed = vector<SymbolicToken>();
             bool empty = true;
 
-            while(terms.size() > 0)
+            while(position < tokens.size())
             {
-                auto result = matcher(terms);
+                auto result = matcher(tokens, position);
                 if (result.result)
                 {
                     empty = false;
-                    terms = result.remaining;
+                    position = result.position;
                     if (not consumed.empty())
                     {
-                        consumed.push_back(SymbolicToken(make_shared<Symbol>(Symbol()), "seperator", "seperator", ""));
+                        consumed.push_back(SymbolicToken(SymbolicToken::seperator));
                     }
                     consumed.insert(consumed.end(), result.consumed.begin(), result.consumed.end());
                 }
@@ -113,45 +181,27 @@ namespace parse
 
             if (nonempty)
             {
-                return Result<SymbolicToken>(!empty, consumed, terms);
+                return TokenResult(!empty, consumed, position);
             }
             else
-            { 
-                return Result<SymbolicToken>(true, consumed, terms);
+            {
+                return TokenResult(true, consumed, position);
             }
         };
     };
 
     /**
-     * Turns annotated tokens into a 2D matrix of tokens
+     * Charges every invocation of a matcher against a parse budget
+     * @param rule Grammar rule the matcher belongs to, reported if the budget runs out
      */
-    vector<vector<SymbolicToken>>
-    reSeperate
-    (const vector<SymbolicToken>& tokens)
+    SymbolicTokenParser
+    budgeted
+    (SymbolicTokenParser matcher, shared_ptr<ParseBudget> budget, string rule)
     {
-        vector<vector<SymbolicToken>> grouped_tokens;
-
-        auto it = tokens.begin();
-        while (it != tokens.end())
+        return [matcher, budget, rule](TokenStream& tokens, int position)
         {
-            if (it->type == "seperator")
-            {
-                if (it + 1!= tokens.end())
-                {
-                    grouped_tokens.push_back(vector<SymbolicToken>());
-                }
-            }
-            else 
-            {
-                if (grouped_tokens.empty())
-                {
-                    grouped_tokens.push_back(vector<SymbolicToken>());
-                }
-                grouped_tokens.back().push_back(*it);
-            }
-            ++it;
-        }
-
-        return grouped_tokens;
+            budget->step(rule, tokens.line(position));
+            return matcher(tokens, position);
+        };
     }
 }
@@ -2,34 +2,56 @@
 #pragma once
 #include "../match/match.hpp"
 #include "../types/symbolictoken.hpp"
+#include "../types/tokenstream.hpp"
+#include "budget.hpp"
 
 /**
  * Collection of parsing tools for SymbolicToken types
  * Allows parsing of type, subtype, or both of a particular token
+ * Parsers match against a TokenStream from a position, instead of copying the remaining tokens
  */
 namespace parse
 {
     using namespace match;
+
+    /**
+     * Result of a parse attempt against a TokenStream
+     * Holds the consumed elements and the position of the first token that was not consumed
+     */
+    struct TokenResult
+    {
+        bool result;
+        vector<SymbolicToken> consumed;
+        int position;
+
+        TokenResult(bool set_result=false,
+                    vector<SymbolicToken> set_consumed=vector<SymbolicToken>(),
+                    int set_position=0);
+    };
+
     /// Overload for match result object
-    using SymbolicTokenParser  = function<Result<SymbolicToken> (vector<SymbolicToken>)>;
+    using SymbolicTokenParser  = function<TokenResult(TokenStream&, int)>;
 
     //Convert a standard parseFunction to one that parses Tokens
     SymbolicTokenParser subTypeParser  (string sub_type);
     SymbolicTokenParser typeParser     (string type);
     SymbolicTokenParser dualTypeParser (string type, string sub_type);
 
+    // Isomorphic to the combinators in the match module
+    SymbolicTokenParser inOrder  (vector<SymbolicTokenParser> matchers);
+    SymbolicTokenParser anyOf    (vector<SymbolicTokenParser> matchers);
+    SymbolicTokenParser optional (SymbolicTokenParser matcher);
+
     SymbolicTokenParser
     discard
     (SymbolicTokenParser matcher);
 
-    vector<SymbolicToken> clean(const vector<SymbolicToken>& tokens);
     // Version of many for seperating nested multi-token parsers. Unnestable
     SymbolicTokenParser
     manySeperated
     (SymbolicTokenParser matcher, bool nonempty=false);
 
-    vector<vector<SymbolicToken>>
-    reSeperate
-    (const vector<SymbolicToken>& tokens);
+    SymbolicTokenParser
+    budgeted
+    (SymbolicTokenParser matcher, shared_ptr<ParseBudget> budget, string rule);
 }
-
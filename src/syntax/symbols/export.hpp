@@ -18,41 +18,43 @@ namespace syntax
     using Newline    = StringLiteral;
     using Comment    = StringLiteral;
 
-    const auto stringGenerator = [](string s){
+    const auto stringGenerator = [](Arena& arena, string s){
         assert (s.size() >= 2);
-        return make_shared<String>(String(string(s.begin() + 1, s.end() - 1)));
+        return arena.make<String>(string(s.begin() + 1, s.end() - 1));
     };
-    const auto keywordGenerator = [](string s){ return make_shared<Keyword>(Keyword(s)); };
-    const auto intGenerator     = [](string s){ return make_shared<Integer>(Integer(stoi(s))); };
-    const auto doubleGenerator  = [](string s){ return make_shared<Double>(Double(stod(s))); };
-    const auto puncGenerator    = [](string s){ return make_shared<Punctuator>(Punctuator(s));};
-    const auto tabGenerator     = [](string s){ return make_shared<Tab>(Tab(s));};
-    const auto commentGenerator = [](string s){ return make_shared<Comment>(Comment(string(s.begin() + 1, s.end()))); };
+    const auto keywordGenerator = [](Arena& arena, string s){ return arena.make<Keyword>(s); };
+    const auto intGenerator     = [](Arena& arena, string s){ return arena.make<Integer>(stoi(s)); };
+    const auto doubleGenerator  = [](Arena& arena, string s){ return arena.make<Double>(stod(s)); };
+    const auto puncGenerator    = [](Arena& arena, string s){ return arena.make<Punctuator>(s);};
+    const auto tabGenerator     = [](Arena& arena, string s){ return arena.make<Tab>(s);};
+    const auto commentGenerator = [](Arena& arena, string s){ return arena.make<Comment>(string(s.begin() + 1, s.end())); };
 
-    const auto literalGenerator = [](string s)
+    const auto newlineGenerator = [](Arena& arena, string s){ return arena.make<Newline>(s);};
+
+    const auto literalGenerator = [](Arena& arena, string s)
     {
-        shared_ptr<Symbol> value;
+        Symbol* value;
         try {
             auto found = s.find(".");
               if (found != std::string::npos)
               {
-                  value = doubleGenerator(s);
+                  value = doubleGenerator(arena, s);
               }
               else
               {
-                  value = intGenerator(s);
+                  value = intGenerator(arena, s);
               }
         }
         catch(std::exception)
         {
-            value = stringGenerator(s);
+            value = stringGenerator(arena, s);
         }
         return value;
     };
 
 
-    const auto single = [](function<shared_ptr<Symbol>(string)> f){
-        return [f](vector<string> values){return f(values[0]); };
+    const auto single = [](function<Symbol*(Arena&, string)> f){
+        return [f](Arena& arena, vector<string> values){return f(arena, values[0]); };
     };
     const unordered_map<string, SymbolGenerator> generatorMap = {
      {"literal",         single(literalGenerator)},
@@ -62,6 +64,7 @@ namespace syntax
      {"punctuator",      single(puncGenerator)},
      {"logicaloperator", single(logicalOpGenerator)},
      {"tab",             single(tabGenerator)},
-     {"comment",         single(commentGenerator)}
+     {"comment",         single(commentGenerator)},
+     {"newline",         single(newlineGenerator)}
     };
 }
@@ -7,7 +7,7 @@ namespace syntax
 Identifier::Identifier(string set_value) : StringLiteral(set_value){}
 
 string Identifier::name(){return value;}
-string Identifier::representation(Generator& generator, unordered_set<string>& generated, string filetype, int nesting)
+string Identifier::representation(Generator& generator, Names& generated, string filetype, int nesting)
 {
     return value;
 }
@@ -15,5 +15,9 @@ string Identifier::abstract(int indent)
 {
     return repeatString("  ", indent) + "Identifier (" + value + ")";
 }
+uint64_t Identifier::hash()
+{
+    return contentHash(value, contentHash("identifier"));
+}
 
 }
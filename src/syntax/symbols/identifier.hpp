@@ -10,8 +10,9 @@ namespace syntax
     {
         Identifier(string set_value);
         virtual string name();
-        virtual string representation(Generator& generator, unordered_set<string>& generated, string filetype, int nesting=0);
+        virtual string representation(Generator& generator, Names& generated, string filetype, int nesting=0);
         virtual string abstract(int indent=0);
+        virtual uint64_t hash();
     };
-    const auto identifierGenerator = [](string s){ return make_shared<Identifier>(Identifier(s)); };
+    const auto identifierGenerator = [](Arena& arena, string s){ return arena.make<Identifier>(s); };
 }
@@ -16,7 +16,7 @@ namespace syntax
         {
             value = set_value; 
         }
-        virtual string representation(Generator& generator, unordered_set<string>& generated, string filetype, int nesting=0)
+        virtual string representation(Generator& generator, Names& generated, string filetype, int nesting=0)
         {
             return std::to_string(value);
         }
@@ -24,6 +24,14 @@ namespace syntax
         {
             return repeatString("  ", indent) + "(" + std::to_string(value) + ")";
         }
+        virtual uint64_t hash()
+        {
+            return contentHash(std::to_string(value), contentHash("literal"));
+        }
+        virtual bool sameStructure(Symbol& other)
+        {
+            return typeid(*this) == typeid(other) and value == static_cast<Literal<T>&>(other).value;
+        }
     };
 
     /**
@@ -35,7 +43,7 @@ namespace syntax
         StringLiteral(string set_value) : value(set_value)
         {
         }
-        virtual string representation(Generator& generator, unordered_set<string>& generated, string filetype, int nesting=0)
+        virtual string representation(Generator& generator, Names& generated, string filetype, int nesting=0)
         {
             return value;
         }
@@ -47,5 +55,13 @@ namespace syntax
         {
             return "none";
         }
+        virtual uint64_t hash()
+        {
+            return contentHash(value, contentHash("string"));
+        }
+        virtual bool sameStructure(Symbol& other) // Also compares Identifiers, which only differ by their type
+        {
+            return typeid(*this) == typeid(other) and value == static_cast<StringLiteral&>(other).value;
+        }
     };
 }
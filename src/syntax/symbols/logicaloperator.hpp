@@ -9,6 +9,6 @@ namespace syntax
      * Abstract representation of an identifier
      */
     using LogicalOperator = StringLiteral;
-    const auto logicalOpGenerator = [](string term){return make_shared<LogicalOperator>(LogicalOperator(term));};
+    const auto logicalOpGenerator = [](Arena& arena, string term){return arena.make<LogicalOperator>(term);};
 }
 
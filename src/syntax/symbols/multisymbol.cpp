@@ -8,30 +8,63 @@ MultiSymbol::MultiSymbol()
 {}
 MultiSymbol::MultiSymbol(string set_tag, MultiSymbolTable set_table) : 
     tag(set_tag),
-    table(set_table)
+    table(std::move(set_table))
 {
     annotation = "multisymbol";
 }
 
-string MultiSymbol::representation(Generator& generator, unordered_set<string>& names, string filetype, int nesting)
+string MultiSymbol::representation(Generator& generator, Names& names, string filetype, int nesting)
 {
-    string representation = "";
-    auto files = generator(names, table, tag);
-    for (auto file : files)
+    return generator.representation(*this, names, filetype, nesting);
+}
+
+/// Hash of the tag and every tagged child, so identical subtrees hash the same wherever they appear
+uint64_t MultiSymbol::hash()
+{
+    if (structure_hash == 0)
     {
-        auto type = get<0>(file);
-        if (type == filetype)
+        uint64_t hash = contentHash(tag, contentHash("multisymbol"));
+        for (auto kv : table)
         {
-            for (auto line : get<2>(file))
+            hash = mixHash(kv.second.size(), contentHash(interned(kv.first), hash));
+            for (auto symbol : kv.second)
             {
-                if (not line.empty())
-                {
-                    representation += line;
-                }
-            } 
+                hash = mixHash(symbol->hash(), hash);
+            }
         }
+        structure_hash = hash;
     }
-    return representation;
+    return structure_hash;
+}
+
+/// Whether other has the same tag and the same children under the same keys, compared all the way down
+bool MultiSymbol::sameStructure(Symbol& other)
+{
+    if (this == &other)
+    {
+        return true;
+    }
+    auto multi = dynamic_cast<MultiSymbol*>(&other);
+    if (multi == nullptr or tag != multi->tag or hash() != multi->hash() or table.size() != multi->table.size())
+    {
+        return false;
+    }
+    for (auto kv : table)
+    {
+        auto children = multi->table.find(kv.first);
+        if (children == nullptr or children->size() != kv.second.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < kv.second.size(); i++)
+        {
+            if (not kv.second[i]->sameStructure(*(*children)[i]))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
 }
 
 string MultiSymbol::abstract(int indent)
@@ -47,7 +80,7 @@ string MultiSymbol::abstract(int indent)
     {
         //if (kv.first != "val")
         {
-            representation += repeatString("  ", next_indent) + kv.first + "\n";
+            representation += repeatString("  ", next_indent) + interned(kv.first) + "\n";
         }
         for (auto symbol : kv.second)
         {
@@ -62,14 +95,29 @@ string MultiSymbol::abstract(int indent)
     return representation;
 }
 
-tuple<string, MultiSymbolTable> MultiSymbol::to_id_group()
+void MultiSymbol::visit(const function<void(string&, MultiSymbolTable&)>& visitor)
 {
-    return make_tuple(tag, table);
+    visitor(tag, table);
+    structure_hash = 0;
 }
-void MultiSymbol::modify_id_group(string set_tag, MultiSymbolTable set_table)
+
+/**
+ * Source line of a table: the first line of any symbol in it, or -1 if none of them were read from the source
+ */
+int firstLine(const MultiSymbolTable& table)
 {
-    tag = set_tag;
-    table = set_table;
+    int line = -1;
+    for (auto kv : table)
+    {
+        for (auto symbol : kv.second)
+        {
+            if (symbol->line >= 0 and (line < 0 or symbol->line < line))
+            {
+                line = symbol->line;
+            }
+        }
+    }
+    return line;
 }
 
 }
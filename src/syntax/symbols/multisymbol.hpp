@@ -15,13 +15,17 @@ struct MultiSymbol : public Symbol
 {
     MultiSymbolTable table;
     string tag;
+    uint64_t structure_hash = 0; // Computed on first use, which is after transformers are done with the table
     MultiSymbol();
     MultiSymbol(string set_tag, MultiSymbolTable set_table);
 
-    virtual string representation(Generator& generator, unordered_set<string>& names, string filetype, int nesting=0);
+    virtual string representation(Generator& generator, Names& names, string filetype, int nesting=0);
     virtual string abstract(int indent=0);
-    virtual tuple<string, MultiSymbolTable> to_id_group();
-    virtual void modify_id_group(string set_tag, MultiSymbolTable set_table);
+    virtual uint64_t hash();
+    virtual bool sameStructure(Symbol& other);
+    virtual void visit(const function<void(string&, MultiSymbolTable&)>& visitor);
 };
 
+int firstLine(const MultiSymbolTable& table);
+
 }
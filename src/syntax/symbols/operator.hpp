@@ -4,5 +4,5 @@
 namespace syntax
 {
     using Operator = StringLiteral;
-    const auto opGenerator = [](string term){ return make_shared<Operator>(Operator(term));};
+    const auto opGenerator = [](Arena& arena, string term){ return arena.make<Operator>(term);};
 }
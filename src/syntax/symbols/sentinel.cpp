@@ -10,6 +10,15 @@ string SentinelSymbol::abstract(int indent)
 {
     return tag;
 }
+uint64_t SentinelSymbol::hash()
+{
+    return contentHash(val, contentHash(tag, contentHash("sentinel")));
+}
+bool SentinelSymbol::sameStructure(Symbol& other)
+{
+    auto sentinel = dynamic_cast<SentinelSymbol*>(&other);
+    return sentinel != nullptr and tag == sentinel->tag and val == sentinel->val;
+}
 SentinelSymbol::SentinelSymbol(){}
 SentinelSymbol::SentinelSymbol(string set_tag, string set_val)
     : tag(set_tag),
@@ -12,6 +12,8 @@ namespace syntax
     {
         string name() override;
         string abstract(int indent=0) override;
+        uint64_t hash() override;
+        bool sameStructure(Symbol& other) override;
 
         string tag = "__none__";
         string val = "__none__";
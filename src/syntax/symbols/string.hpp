@@ -7,7 +7,7 @@ namespace syntax
     struct String : public StringLiteral 
     {
         String(string set_value) : StringLiteral(set_value){}
-        virtual string representation(Generator& generator, unordered_set<string>& generated, string filetype, int nesting=0)
+        virtual string representation(Generator& generator, Names& generated, string filetype, int nesting=0)
         {
             return "\"" + value + "\"";
         }
@@ -2,7 +2,7 @@
 #include "symbol.hpp"
 namespace syntax
 {
-string Symbol::representation(Generator& generator, unordered_set<string>& generated, string filetype, int nesting)
+string Symbol::representation(Generator& generator, Names& generated, string filetype, int nesting)
 {
     return "/*No Representation*/";
 }
@@ -11,13 +11,16 @@ string Symbol::abstract(int indent)
     return "Symbol";
 }
 string Symbol::name(){return "none";}
-Symbol::Symbol(){}
-tuple<string, MultiSymbolTable> Symbol::to_id_group()
+uint64_t Symbol::hash()
+{
+    return contentHash(annotation);
+}
+bool Symbol::sameStructure(Symbol& other)
 {
-    return make_tuple("undefined", MultiSymbolTable());
+    return typeid(*this) == typeid(other) and annotation == other.annotation;
 }
-void Symbol::modify_id_group(string, MultiSymbolTable)
+Symbol::Symbol(){}
+void Symbol::visit(const function<void(string&, MultiSymbolTable&)>& visitor)
 {
-    throw std::exception();
 }
 }
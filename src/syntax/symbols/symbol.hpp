@@ -1,6 +1,7 @@
 /// Copyright 2017 Lucas Saldyt
 #pragma once
 #include "../import.hpp"
+#include <typeinfo>
 
 /**
  * Classes that represent core language features: identifiers, literals, etc
@@ -14,17 +15,25 @@ namespace syntax
      */
     struct Symbol
     {
-        virtual string representation(Generator& generator, unordered_set<string>& generated, string filetype, int nesting=0);
+        virtual string representation(Generator& generator, Names& generated, string filetype, int nesting=0);
         virtual string abstract(int indent=0);
         virtual string name();
 
-        virtual tuple<string, MultiSymbolTable> to_id_group();
-        virtual void modify_id_group(string, MultiSymbolTable);
+        /// Structural hash: symbols with equal hashes have the same name and generate the same code
+        virtual uint64_t hash();
+
+        /// Whether other is the same kind of symbol with the same content, so that it generates the same code
+        virtual bool sameStructure(Symbol& other);
+
+        /// Lets visitor rewrite the tag and table of a MultiSymbol in place. Other symbols have neither, and are skipped
+        virtual void visit(const function<void(string&, MultiSymbolTable&)>& visitor);
 
         string annotation = "symbol";
+        int line = -1; // Source line the symbol was read from, or -1 if it was made by a transformer or pass
 
         Symbol();
     };
 
-    using SymbolGenerator  = function<shared_ptr<Symbol>(vector<string>)>;
+    /// Constructs a Symbol from token text, inside the arena of the file it belongs to
+    using SymbolGenerator  = function<Symbol*(Arena&, vector<string>)>;
 }
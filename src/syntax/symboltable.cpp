@@ -0,0 +1,80 @@
+/// Copyright 2017 Lucas Saldyt
+#include "symboltable.hpp"
+
+namespace syntax
+{
+
+/// The symbols under a tag, adding an empty list if the tag is new
+SymbolList& MultiSymbolTable::operator[](int tag)
+{
+    auto found = find(tag);
+    if (found)
+    {
+        return *found;
+    }
+    tags.push_back(tag);
+    return lists.emplace_back();
+}
+
+SymbolList& MultiSymbolTable::operator[](const string& tag)
+{
+    return (*this)[intern(tag)];
+}
+
+/// The symbols under a tag, or nullptr if the table doesn't have it
+SymbolList* MultiSymbolTable::find(int tag)
+{
+    for (size_t i = 0; i < tags.size(); i++)
+    {
+        if (tags[i] == tag)
+        {
+            return &lists[i];
+        }
+    }
+    return nullptr;
+}
+
+const SymbolList* MultiSymbolTable::find(int tag) const
+{
+    return const_cast<MultiSymbolTable*>(this)->find(tag);
+}
+
+void MultiSymbolTable::erase(int tag)
+{
+    for (size_t i = 0; i < tags.size(); i++)
+    {
+        if (tags[i] == tag)
+        {
+            tags.erase(tags.begin() + i);
+            lists.erase(lists.begin() + i);
+            return;
+        }
+    }
+}
+
+void MultiSymbolTable::erase(const string& tag)
+{
+    erase(intern(tag));
+}
+
+size_t MultiSymbolTable::size() const
+{
+    return tags.size();
+}
+
+bool MultiSymbolTable::empty() const
+{
+    return tags.empty();
+}
+
+bool contains(const MultiSymbolTable& table, int tag)
+{
+    return table.find(tag) != nullptr;
+}
+
+bool contains(const MultiSymbolTable& table, const string& tag)
+{
+    return table.find(intern(tag)) != nullptr;
+}
+
+}
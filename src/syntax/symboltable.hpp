@@ -0,0 +1,72 @@
+/// Copyright 2017 Lucas Saldyt
+#pragma once
+#include "../tools/tools.hpp"
+
+namespace syntax
+{
+using namespace tools;
+
+class Symbol;
+
+/// Symbols matched under a single tag. Most tags hold one or two, which are stored inline
+using SymbolList = SmallVector<Symbol*, 2>;
+
+/**
+ * Children of a MultiSymbol, grouped by the tag they were matched under (i.e. val, body, args)
+ * A flat map keyed by interned tags: nodes usually have one to four tags, so the keys sit inline in one cache line
+ * and are scanned linearly, next to the inline symbol lists. Tags keep the order they were added in
+ * Inserting or erasing a tag may move the other lists, so don't hold on to references across those
+ */
+class MultiSymbolTable
+{
+public:
+    /// Key/value view of an entry, read like a map's pair (first is the interned tag)
+    template <typename List>
+    struct Entry
+    {
+        int   first;
+        List& second;
+    };
+
+    template <typename Table, typename List>
+    class basic_iterator
+    {
+    public:
+        basic_iterator(Table* set_table, size_t set_index) : table(set_table), index(set_index) {}
+        Entry<List> operator*() const { return Entry<List>{table->tags[index], table->lists[index]}; }
+        basic_iterator& operator++() { index++; return *this; }
+        bool operator==(const basic_iterator& other) const { return index == other.index; }
+        bool operator!=(const basic_iterator& other) const { return index != other.index; }
+    private:
+        Table* table;
+        size_t index;
+    };
+
+    using iterator       = basic_iterator<MultiSymbolTable, SymbolList>;
+    using const_iterator = basic_iterator<const MultiSymbolTable, const SymbolList>;
+
+    SymbolList& operator[](int tag);
+    SymbolList& operator[](const string& tag);
+
+    SymbolList*       find(int tag);
+    const SymbolList* find(int tag) const;
+
+    void erase(int tag);
+    void erase(const string& tag);
+
+    size_t size() const;
+    bool   empty() const;
+
+    iterator       begin()       { return iterator(this, 0); }
+    iterator       end()         { return iterator(this, tags.size()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end()   const { return const_iterator(this, tags.size()); }
+
+private:
+    SmallVector<int, 4>        tags;
+    SmallVector<SymbolList, 4> lists;
+};
+
+bool contains(const MultiSymbolTable& table, int tag);
+bool contains(const MultiSymbolTable& table, const string& tag);
+}
@@ -0,0 +1,117 @@
+/// Copyright 2017 Lucas Saldyt
+#include "arena.hpp"
+#include <cstddef>
+
+namespace tools
+{
+
+Arena::Arena(size_t set_block_size) :
+    block_size(set_block_size)
+{
+}
+
+Arena::~Arena()
+{
+    release(0);
+}
+
+Arena::Arena(Arena&& other) :
+    block_size(other.block_size),
+    blocks(std::move(other.blocks)),
+    current(other.current),
+    offset(other.offset),
+    destructors(std::move(other.destructors))
+{
+    other.blocks.clear();
+    other.destructors.clear();
+    other.current = 0;
+    other.offset  = 0;
+}
+
+Arena& Arena::operator=(Arena&& other)
+{
+    if (this != &other)
+    {
+        release(0);
+        block_size  = other.block_size;
+        blocks      = std::move(other.blocks);
+        current     = other.current;
+        offset      = other.offset;
+        destructors = std::move(other.destructors);
+        other.blocks.clear();
+        other.destructors.clear();
+        other.current = 0;
+        other.offset  = 0;
+    }
+    return *this;
+}
+
+/**
+ * Reserve raw memory in the arena
+ * Objects larger than a block get a block of their own
+ * @param size      Bytes needed
+ * @param alignment Alignment needed, at most that of max_align_t
+ */
+void* Arena::allocate(size_t size, size_t alignment)
+{
+    assert(alignment <= alignof(std::max_align_t));
+    if (current < blocks.size())
+    {
+        size_t start = (offset + alignment - 1) / alignment * alignment;
+        if (start + size <= get<1>(blocks[current]))
+        {
+            offset = start + size;
+            return get<0>(blocks[current]).get() + start;
+        }
+    }
+    // Move on to the next block, reusing one kept from before a rewind if it is large enough
+    size_t next = current < blocks.size() ? current + 1 : current;
+    if (next == blocks.size() or get<1>(blocks[next]) < size)
+    {
+        size_t capacity = std::max(block_size, size);
+        blocks.insert(blocks.begin() + next, make_tuple(std::unique_ptr<char[]>(new char[capacity]), capacity));
+    }
+    current = next;
+    offset  = size;
+    return get<0>(blocks[current]).get();
+}
+
+Arena::Mark Arena::mark() const
+{
+    return Mark{current, offset, destructors.size()};
+}
+
+/**
+ * Destroy everything allocated since a mark, and reuse its memory for later allocations
+ * @param to Mark taken earlier from this arena
+ */
+void Arena::rewind(Mark to)
+{
+    release(to.destructors);
+    current = to.block;
+    offset  = to.offset;
+}
+
+/// Bytes handed out so far, including padding and the unused tails of full blocks
+size_t Arena::used() const
+{
+    size_t total = 0;
+    for (size_t i = 0; i < current and i < blocks.size(); i++)
+    {
+        total += get<1>(blocks[i]);
+    }
+    return total + offset;
+}
+
+/// Run destructors, newest first, until only the first keep remain
+void Arena::release(size_t keep)
+{
+    while (destructors.size() > keep)
+    {
+        auto& destructor = destructors.back();
+        get<0>(destructor)(get<1>(destructor));
+        destructors.pop_back();
+    }
+}
+
+}
@@ -0,0 +1,68 @@
+/// Copyright 2017 Lucas Saldyt
+#pragma once
+#include "base.hpp"
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace tools
+{
+
+/**
+ * Bump allocator for objects that all die together (i.e. the AST of a single file)
+ * Objects are placement-constructed into large blocks and referenced by raw pointer.
+ * Nothing is freed individually: destructors run, newest first, when the arena is destroyed or rewound
+ */
+class Arena
+{
+public:
+    /// Position in the arena, everything allocated after it can be released with rewind()
+    struct Mark
+    {
+        size_t block;
+        size_t offset;
+        size_t destructors;
+    };
+
+    Arena(size_t set_block_size=1 << 16);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena(Arena&& other);
+    Arena& operator=(Arena&& other);
+
+    /**
+     * Construct a T inside the arena
+     * @return Pointer that stays valid until the arena is destroyed, or rewound past it
+     */
+    template <typename T, typename... Args>
+    T* make(Args&&... args)
+    {
+        void* memory = allocate(sizeof(T), alignof(T));
+        T* t = new (memory) T(std::forward<Args>(args)...);
+        if (not std::is_trivially_destructible<T>::value)
+        {
+            destructors.push_back(make_tuple([](void* p){ static_cast<T*>(p)->~T(); }, (void*)t));
+        }
+        return t;
+    }
+
+    void* allocate(size_t size, size_t alignment);
+
+    Mark mark() const;
+    void rewind(Mark to);
+
+    size_t used() const;
+
+private:
+    size_t block_size;
+    vector<tuple<std::unique_ptr<char[]>, size_t>> blocks; // Storage and capacity. Blocks past the current one are kept for reuse after a rewind
+    size_t current = 0;
+    size_t offset  = 0;
+    vector<tuple<void(*)(void*), void*>> destructors;
+
+    void release(size_t keep);
+};
+
+}
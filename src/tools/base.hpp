@@ -8,6 +8,7 @@
 #include <memory>
 #include <exception>
 #include <algorithm>
+#include <functional>
 
 #include <assert.h>
 #include <sys/time.h> // To keep constant frametime
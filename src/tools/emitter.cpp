@@ -0,0 +1,80 @@
+/// Copyright 2017 Lucas Saldyt
+#include "emitter.hpp"
+
+namespace tools
+{
+
+/**
+ * Opens a file for writing, truncating it
+ * @param filename File to write to
+ * @param set_capacity Bytes buffered before they are written
+ */
+Emitter::Emitter(string filename, size_t set_capacity) : file(std::fopen(filename.c_str(), "w")), capacity(set_capacity)
+{
+    buffer.reserve(capacity);
+}
+
+Emitter::Emitter(Emitter&& other) : file(other.file), buffer(std::move(other.buffer)), capacity(other.capacity)
+{
+    other.file = nullptr;
+    other.buffer.clear();
+}
+
+Emitter::~Emitter()
+{
+    if (file != nullptr)
+    {
+        flush();
+        std::fclose(file);
+    }
+}
+
+/**
+ * Appends text, writing the buffer out first if the text would overflow it
+ * Text larger than the buffer is written directly
+ */
+void Emitter::append(const string& text)
+{
+    if (buffer.size() + text.size() > capacity)
+    {
+        flush();
+        if (text.size() > capacity)
+        {
+            if (file != nullptr)
+            {
+                std::fwrite(text.data(), 1, text.size(), file);
+            }
+            return;
+        }
+    }
+    buffer += text;
+}
+
+void Emitter::line(const string& text)
+{
+    append(text);
+    append("\n");
+}
+
+void Emitter::lines(const vector<string>& content)
+{
+    for (const auto& text : content)
+    {
+        line(text);
+    }
+}
+
+/**
+ * Writes everything buffered to the file
+ */
+void Emitter::flush()
+{
+    if (file != nullptr and not buffer.empty())
+    {
+        std::fwrite(buffer.data(), 1, buffer.size(), file);
+        std::fflush(file);
+    }
+    buffer.clear();
+}
+
+}
@@ -0,0 +1,34 @@
+/// Copyright 2017 Lucas Saldyt
+#pragma once
+#include "base.hpp"
+#include <cstdio>
+
+namespace tools
+{
+
+/**
+ * Buffered writer for a generated file
+ * Code is appended as it is generated and written out in large blocks, so a whole file is never held in memory
+ */
+class Emitter
+{
+public:
+    Emitter(string filename, size_t set_capacity=1 << 16);
+    ~Emitter();
+
+    Emitter(const Emitter&) = delete;
+    Emitter& operator=(const Emitter&) = delete;
+    Emitter(Emitter&& other);
+
+    void append(const string& text);
+    void line(const string& text);
+    void lines(const vector<string>& content);
+    void flush();
+
+private:
+    std::FILE* file;
+    string buffer;
+    size_t capacity;
+};
+
+}
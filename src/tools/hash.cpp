@@ -0,0 +1,39 @@
+/// Copyright 2017 Lucas Saldyt
+#include "hash.hpp"
+
+namespace tools
+{
+
+uint64_t contentHash(const string& s, uint64_t hash)
+{
+    // Length first, so that combining "ab" + "c" and "a" + "bc" differ
+    hash = mixHash(s.size(), hash);
+    for (unsigned char c : s)
+    {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+uint64_t mixHash(uint64_t value, uint64_t hash)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        hash = (hash ^ ((value >> (i * 8)) & 0xff)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+string hexHash(uint64_t hash)
+{
+    const char* digits = "0123456789abcdef";
+    string hex(16, '0');
+    for (int i = 15; i >= 0; i--)
+    {
+        hex[i] = digits[hash & 0xf];
+        hash >>= 4;
+    }
+    return hex;
+}
+
+}
@@ -0,0 +1,23 @@
+/// Copyright 2017 Lucas Saldyt
+#pragma once
+#include "base.hpp"
+#include <cstdint>
+
+namespace tools
+{
+
+const uint64_t hash_seed = 14695981039346656037ull;
+
+/**
+ * 64 bit FNV-1a hash of a string, continuing from a previous hash so several strings can be combined
+ * Stable across runs and platforms, so it can be used to key files on disk
+ */
+uint64_t contentHash(const string& s, uint64_t hash=hash_seed);
+
+/// Combines a number, i.e. another hash, into a hash
+uint64_t mixHash(uint64_t value, uint64_t hash=hash_seed);
+
+/// Hash as a fixed width hexadecimal string, i.e. for filenames
+string hexHash(uint64_t hash);
+
+}
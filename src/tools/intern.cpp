@@ -0,0 +1,46 @@
+/// Copyright 2017 Lucas Saldyt
+#include "intern.hpp"
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+
+namespace tools
+{
+
+namespace
+{
+    std::shared_mutex intern_mutex; // Lookups, which are nearly all calls, share it, so threads only wait on new strings
+    unordered_map<string, int> intern_ids;
+    std::deque<string> intern_strings; // A deque never moves its elements, so references stay valid
+}
+
+int intern(const string& s)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(intern_mutex);
+        auto found = intern_ids.find(s);
+        if (found != intern_ids.end())
+        {
+            return found->second;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(intern_mutex);
+    auto found = intern_ids.find(s); // Another thread may have added it since
+    if (found != intern_ids.end())
+    {
+        return found->second;
+    }
+    int id = intern_strings.size();
+    intern_strings.push_back(s);
+    intern_ids[s] = id;
+    return id;
+}
+
+const string& interned(int id)
+{
+    std::shared_lock<std::shared_mutex> lock(intern_mutex); // push_back can still reallocate the deque's index of blocks
+    assert(id >= 0 and id < intern_strings.size());
+    return intern_strings[id];
+}
+
+}
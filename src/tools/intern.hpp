@@ -0,0 +1,17 @@
+/// Copyright 2017 Lucas Saldyt
+#pragma once
+#include "base.hpp"
+
+namespace tools
+{
+
+/**
+ * Maps strings to small, dense integer ids that stay valid for the lifetime of the program
+ * Lets hot paths compare and index by id instead of by string
+ */
+int intern(const string& s);
+
+/// The string that an id returned by intern() stands for
+const string& interned(int id);
+
+}
@@ -1,5 +1,6 @@
 /// Copyright 2017 Lucas Saldyt
 #include "io.hpp"
+#include "emitter.hpp"
 
 namespace tools
 {
@@ -22,12 +23,7 @@ namespace tools
     void writeFile(vector<string> content, string filename)
     {
         // Write a vector of lines into a file
-        std::ofstream file;
-        file.open(filename);
-        for (auto line : content)
-        {
-            file << (line + "\n");
-        }
-        file.close();
+        Emitter file(filename);
+        file.lines(content);
     }
 }
@@ -17,7 +17,9 @@ void writeFile(vector<string> content, string filename);
 /// Abstract IO
 template <typename T>
 void print(T t) {
-    std::cout << t << "\n";
+    std::ostringstream line; // Written in one piece, so lines printed by different threads don't mix
+    line << t << "\n";
+    std::cout << line.str();
 }
 
 /// Abstract IO
@@ -12,9 +12,52 @@ OutputManager::OutputManager(int verbosity) :
 void OutputManager::log(std::string message, int message_level)
 {
     assert(message_level >= 1);
-    if (message_level <= level)
+    if (enabled(message_level))
     {
-        print(repeatString("    ", message_level - 1) + message);
+        auto line = repeatString("    ", message_level - 1) + message;
+        if (buffer != nullptr)
+        {
+            buffer->push_back(line);
+        }
+        else
+        {
+            print(line);
+        }
+    }
+}
+
+/// Checks if messages at a level are printed, so callers can skip building ones that aren't
+bool OutputManager::enabled(int message_level) const
+{
+    return message_level <= level;
+}
+
+/**
+ * Logger with the same verbosity that adds its messages to lines instead of printing them,
+ * so work done on another thread can be logged in order once it is finished
+ */
+OutputManager OutputManager::buffered(vector<string>& lines) const
+{
+    OutputManager logger(level);
+    logger.buffer = &lines;
+    return logger;
+}
+
+/**
+ * Logs messages that were collected by a buffered() logger, as they were, i.e. into this logger's own buffer if it has one
+ */
+void OutputManager::replay(const vector<string>& lines)
+{
+    for (const auto& line : lines)
+    {
+        if (buffer != nullptr)
+        {
+            buffer->push_back(line);
+        }
+        else
+        {
+            print(line);
+        }
     }
 }
 
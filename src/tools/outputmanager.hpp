@@ -11,9 +11,13 @@ public:
     OutputManager(int verbosity=0);
 
     void log(std::string message, int message_level=1);
+    bool enabled(int message_level=1) const;
+    OutputManager buffered(vector<string>& lines) const;
+    void replay(const vector<string>& lines);
 
 private:
     int level;
+    vector<string>* buffer = nullptr; // Collects messages instead of printing them, see buffered()
 };
 
 }
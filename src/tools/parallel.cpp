@@ -0,0 +1,72 @@
+/// Copyright 2017 Lucas Saldyt
+#include "parallel.hpp"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace tools
+{
+
+/// Number of threads the machine runs at once, or 1 if it can't tell
+int hardwareJobs()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * Calls body on every index below count, spread over up to jobs threads, which take the next index as they finish one
+ * With a single job (or index) everything runs on the calling thread, in order
+ * @param body Called with the index and the worker running it, which is below jobs, so workers can keep state of their own
+ * If body throws, no more indices are started, and the first exception is rethrown once every worker has stopped
+ */
+void parallelFor(size_t count, int jobs, const function<void(size_t, int)>& body)
+{
+    int workers = std::min((size_t)std::max(jobs, 1), count);
+    if (workers <= 1)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            body(i, 0);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::atomic<bool>   failed(false);
+    std::exception_ptr  error;
+    std::mutex          error_mutex;
+    const auto work = [&](int worker)
+    {
+        for (size_t i = next++; i < count and not failed; i = next++)
+        {
+            try
+            {
+                body(i, worker);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (not failed.exchange(true))
+                {
+                    error = std::current_exception();
+                }
+            }
+        }
+    };
+    vector<std::thread> threads;
+    for (int worker = 1; worker < workers; worker++)
+    {
+        threads.emplace_back(work, worker);
+    }
+    work(0);
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+}
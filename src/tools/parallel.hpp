@@ -0,0 +1,11 @@
+/// Copyright 2017 Lucas Saldyt
+#pragma once
+#include "base.hpp"
+
+namespace tools
+{
+
+int hardwareJobs();
+void parallelFor(size_t count, int jobs, const function<void(size_t, int)>& body);
+
+}
@@ -0,0 +1,249 @@
+/// Copyright 2017 Lucas Saldyt
+#pragma once
+#include "base.hpp"
+#include <initializer_list>
+#include <new>
+#include <utility>
+
+namespace tools
+{
+
+/**
+ * Vector that stores its first N elements inline, only allocating once it grows past them
+ * Used for the many short lists in the AST, which usually hold one or two elements
+ */
+template <typename T, int N>
+class SmallVector
+{
+public:
+    using value_type     = T;
+    using iterator       = T*;
+    using const_iterator = const T*;
+
+    SmallVector() {}
+
+    SmallVector(std::initializer_list<T> values)
+    {
+        reserve(values.size());
+        for (const auto& v : values)
+        {
+            push_back(v);
+        }
+    }
+
+    SmallVector(const vector<T>& values)
+    {
+        reserve(values.size());
+        for (const auto& v : values)
+        {
+            push_back(v);
+        }
+    }
+
+    SmallVector(const SmallVector& other)
+    {
+        reserve(other.size());
+        for (const auto& v : other)
+        {
+            push_back(v);
+        }
+    }
+
+    SmallVector(SmallVector&& other)
+    {
+        take(other);
+    }
+
+    SmallVector& operator=(const SmallVector& other)
+    {
+        if (this != &other)
+        {
+            clear();
+            reserve(other.size());
+            for (const auto& v : other)
+            {
+                push_back(v);
+            }
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other)
+    {
+        if (this != &other)
+        {
+            clear();
+            deallocate();
+            take(other);
+        }
+        return *this;
+    }
+
+    ~SmallVector()
+    {
+        clear();
+        deallocate();
+    }
+
+    iterator       begin()       { return data_; }
+    iterator       end()         { return data_ + size_; }
+    const_iterator begin() const { return data_; }
+    const_iterator end()   const { return data_ + size_; }
+
+    size_t size()  const { return size_; }
+    bool   empty() const { return size_ == 0; }
+    bool   onHeap() const { return data_ != local(); }
+
+    T&       operator[](size_t i)       { return data_[i]; }
+    const T& operator[](size_t i) const { return data_[i]; }
+    T&       front()       { return data_[0]; }
+    const T& front() const { return data_[0]; }
+    T&       back()        { return data_[size_ - 1]; }
+    const T& back()  const { return data_[size_ - 1]; }
+
+    void push_back(const T& value)
+    {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value)
+    {
+        emplace_back(std::move(value));
+    }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args)
+    {
+        if (size_ == capacity_)
+        {
+            // Construct first, in case args refer to an element that is about to move
+            T value(std::forward<Args>(args)...);
+            reserve(capacity_ * 2);
+            new (data_ + size_) T(std::move(value));
+        }
+        else
+        {
+            new (data_ + size_) T(std::forward<Args>(args)...);
+        }
+        return data_[size_++];
+    }
+
+    void pop_back()
+    {
+        data_[--size_].~T();
+    }
+
+    /// Remove the element at position, keeping the order of the others
+    iterator erase(iterator position)
+    {
+        std::move(position + 1, end(), position);
+        pop_back();
+        return position;
+    }
+
+    template <typename It>
+    void insert(iterator position, It first, It last)
+    {
+        assert(position == end()); // Only appending is needed so far
+        reserve(size_ + std::distance(first, last));
+        for (; first != last; first++)
+        {
+            emplace_back(*first);
+        }
+    }
+
+    void reserve(size_t capacity)
+    {
+        if (capacity <= capacity_)
+        {
+            return;
+        }
+        T* grown = static_cast<T*>(::operator new(capacity * sizeof(T)));
+        for (size_t i = 0; i < size_; i++)
+        {
+            new (grown + i) T(std::move(data_[i]));
+            data_[i].~T();
+        }
+        deallocate();
+        data_     = grown;
+        capacity_ = capacity;
+    }
+
+    void clear()
+    {
+        for (size_t i = 0; i < size_; i++)
+        {
+            data_[i].~T();
+        }
+        size_ = 0;
+    }
+
+    bool operator==(const SmallVector& other) const
+    {
+        return size_ == other.size_ and std::equal(begin(), end(), other.begin());
+    }
+
+    bool operator!=(const SmallVector& other) const
+    {
+        return not (*this == other);
+    }
+
+    operator vector<T>() const
+    {
+        return vector<T>(begin(), end());
+    }
+
+private:
+    T*       data_     = local();
+    unsigned size_     = 0;
+    unsigned capacity_ = N;
+    alignas(T) unsigned char storage[N * sizeof(T)];
+
+    T*       local()       { return reinterpret_cast<T*>(storage); }
+    const T* local() const { return reinterpret_cast<const T*>(storage); }
+
+    void deallocate()
+    {
+        if (onHeap())
+        {
+            ::operator delete(data_);
+            data_     = local();
+            capacity_ = N;
+        }
+    }
+
+    /// Steal the contents of other, which must be empty and inline beforehand
+    void take(SmallVector& other)
+    {
+        if (other.onHeap())
+        {
+            data_     = other.data_;
+            size_     = other.size_;
+            capacity_ = other.capacity_;
+            other.data_     = other.local();
+            other.size_     = 0;
+            other.capacity_ = N;
+        }
+        else
+        {
+            for (size_t i = 0; i < other.size_; i++)
+            {
+                new (data_ + i) T(std::move(other.data_[i]));
+            }
+            size_ = other.size_;
+            other.clear();
+        }
+    }
+};
+
+template <typename T, int N>
+void concat(SmallVector<T, N>& a, const SmallVector<T, N>& b)
+{
+    a.reserve(a.size() + b.size());
+    for (size_t i = 0, n = b.size(); i < n; i++) // b may be a
+    {
+        a.push_back(b[i]);
+    }
+}
+
+}
@@ -3,3 +3,9 @@
 #include "base.hpp"
 #include "outputmanager.hpp"
 
+#include "intern.hpp"
+#include "arena.hpp"
+#include "hash.hpp"
+#include "smallvector.hpp"
+#include "parallel.hpp"
+#include "emitter.hpp"
@@ -0,0 +1,399 @@
+/// Copyright 2017 Lucas Saldyt
+#include "rewrite.hpp"
+#include "../syntax/symbols/export.hpp"
+#include <cctype>
+
+namespace transform
+{
+
+namespace
+{
+    /// Reads the terms of a rewrite rule: names, and the punctuation ( ) , = $ between them
+    struct RuleReader
+    {
+        const string& line;
+        size_t position = 0;
+
+        RuleReader(const string& set_line, size_t set_position=0) : line(set_line), position(set_position) {}
+
+        void skip()
+        {
+            while (position < line.size() and std::isspace(line[position]))
+            {
+                position++;
+            }
+        }
+
+        bool accept(char c)
+        {
+            skip();
+            if (position < line.size() and line[position] == c)
+            {
+                position++;
+                return true;
+            }
+            return false;
+        }
+
+        void expect(char c)
+        {
+            err_if(not accept(c), "Expected '" + string(1, c) + "' at " + std::to_string(position) + " in rewrite rule: " + line);
+        }
+
+        string name()
+        {
+            skip();
+            auto start = position;
+            while (position < line.size() and not std::isspace(line[position]) and string("(),=$").find(line[position]) == string::npos)
+            {
+                position++;
+            }
+            err_if(start == position, "Expected a name at " + std::to_string(start) + " in rewrite rule: " + line);
+            return line.substr(start, position - start);
+        }
+
+        bool done()
+        {
+            skip();
+            return position == line.size();
+        }
+    };
+
+    void readPattern(RuleReader& reader, PatternPath path, RewriteRule& rule)
+    {
+        bool root = path.empty();
+        if (reader.accept('$'))
+        {
+            err_if(root, "A rewrite rule must match a tag, not a capture: " + rule.source);
+            auto name = reader.name();
+            if (name.back() == '*')
+            {
+                name.pop_back();
+            }
+            else
+            {
+                rule.checks.push_back(PatternCheck{path, "", true});
+            }
+            rule.captures.push_back(make_tuple(name, path));
+            return;
+        }
+        auto label = reader.name();
+        if (label == "_")
+        {
+            err_if(root, "A rewrite rule must match a tag, not _: " + rule.source);
+            rule.checks.push_back(PatternCheck{path, "", true});
+            return;
+        }
+        rule.checks.push_back(PatternCheck{path, label, false});
+        if (reader.accept('('))
+        {
+            do
+            {
+                auto child = path;
+                child.push_back(intern(reader.name()));
+                reader.expect('=');
+                readPattern(reader, child, rule);
+            } while (reader.accept(','));
+            reader.expect(')');
+        }
+    }
+
+    /// The only symbol at a path, or nullptr if there isn't exactly one there
+    Symbol* symbolAt(MultiSymbolTable& ms_table, const PatternPath& path)
+    {
+        auto* table = &ms_table;
+        Symbol* symbol = nullptr;
+        for (auto key : path)
+        {
+            if (symbol != nullptr)
+            {
+                auto multi = dynamic_cast<MultiSymbol*>(symbol);
+                if (multi == nullptr)
+                {
+                    return nullptr;
+                }
+                table = &multi->table;
+            }
+            auto symbols = table->find(key);
+            if (symbols == nullptr or symbols->size() != 1)
+            {
+                return nullptr;
+            }
+            symbol = (*symbols)[0];
+        }
+        return symbol;
+    }
+
+    /// Symbols under the last tag of a path, whose parents were already matched
+    SymbolList symbolsAt(MultiSymbolTable& ms_table, const PatternPath& path)
+    {
+        auto* table = &ms_table;
+        if (path.size() > 1)
+        {
+            auto parent = dynamic_cast<MultiSymbol*>(symbolAt(ms_table, PatternPath(path.begin(), path.end() - 1)));
+            assert(parent != nullptr);
+            table = &parent->table;
+        }
+        auto symbols = table->find(path.back());
+        return symbols == nullptr ? SymbolList() : *symbols;
+    }
+
+    const PatternCheck* checkOn(const vector<PatternCheck>& checks, const PatternPath& path)
+    {
+        for (const auto& check : checks)
+        {
+            if (check.path == path)
+            {
+                return &check;
+            }
+        }
+        return nullptr;
+    }
+
+    vector<PatternCheck> without(const vector<PatternCheck>& checks, const PatternCheck* check)
+    {
+        vector<PatternCheck> remaining;
+        for (const auto& other : checks)
+        {
+            if (&other != check)
+            {
+                remaining.push_back(other);
+            }
+        }
+        return remaining;
+    }
+
+    /// Text that identifies a set of candidates: the index of each rule, then the path and label of each check it has left
+    string candidatesKey(const vector<tuple<int, vector<PatternCheck>>>& candidates)
+    {
+        string key;
+        for (const auto& candidate : candidates)
+        {
+            key += std::to_string(get<0>(candidate)) + ":";
+            for (const auto& check : get<1>(candidate))
+            {
+                for (auto step : check.path)
+                {
+                    key += std::to_string(step) + ".";
+                }
+                key += check.any ? "*;" : std::to_string(check.label.size()) + "=" + check.label + ";"; // Labels may hold any punctuation
+            }
+            key += "|";
+        }
+        return key;
+    }
+}
+
+/**
+ * Parses a rewrite rule line, see RewriteRule
+ * @param line i.e. "print(val=$x) -> functioncall(args=$x)"
+ * @return Rule with its pattern flattened into checks, parents first
+ */
+RewriteRule parseRewriteRule(const string& line)
+{
+    RewriteRule rule;
+    rule.source = line;
+    auto arrow  = line.find("->");
+    err_if(arrow == string::npos, "Rewrite rule has no \"->\": " + line);
+
+    auto pattern = line.substr(0, arrow);
+    RuleReader reader(pattern);
+    readPattern(reader, {}, rule);
+    err_if(not reader.done(), "Unexpected text after the pattern of rewrite rule: " + line);
+
+    auto replacement = line.substr(arrow + 2);
+    RuleReader replacement_reader(replacement);
+    rule.tag = replacement_reader.name();
+    if (replacement_reader.accept('('))
+    {
+        rule.retag_only = false;
+        do
+        {
+            auto key = intern(replacement_reader.name());
+            replacement_reader.expect('=');
+            replacement_reader.expect('$');
+            auto name = replacement_reader.name();
+            if (name.back() == '*')
+            {
+                name.pop_back();
+            }
+            bool captured = std::any_of(rule.captures.begin(), rule.captures.end(), [&](const auto& c){ return get<0>(c) == name; });
+            err_if(not captured, "$" + name + " is not captured by rewrite rule: " + line);
+            rule.table.push_back(make_tuple(key, name));
+        } while (replacement_reader.accept(','));
+        replacement_reader.expect(')');
+    }
+    err_if(not replacement_reader.done(), "Unexpected text after the replacement of rewrite rule: " + line);
+    return rule;
+}
+
+RewriteAutomaton::RewriteAutomaton()
+{
+}
+
+/**
+ * Compiles rewrite rules
+ * @param lines One rule per line, in order of priority. Empty lines are skipped
+ */
+RewriteAutomaton::RewriteAutomaton(const vector<string>& lines)
+{
+    Candidates candidates;
+    for (const auto& line : lines)
+    {
+        if (line.find_first_not_of(" \t") != string::npos)
+        {
+            rules.push_back(parseRewriteRule(line));
+            candidates.push_back(make_tuple(rules.size() - 1, rules.back().checks));
+        }
+    }
+    if (not rules.empty())
+    {
+        unordered_map<string, int> built;
+        build(candidates, built);
+    }
+}
+
+/**
+ * Builds the state testing the first remaining check of the first candidate, and the states after it
+ * Candidates that don't care about the tested path follow every edge, so a single path through the tree finds the
+ * first matching rule
+ * @param candidates Rules that can still match, in priority order, with the checks they have left
+ * @param built State already built for each set of candidates (see candidatesKey)
+ * @return Index of the state, or -1 if no rule can match
+ */
+int RewriteAutomaton::build(const Candidates& candidates, unordered_map<string, int>& built)
+{
+    if (candidates.empty())
+    {
+        return -1;
+    }
+    auto key = candidatesKey(candidates);
+    auto found = built.find(key);
+    if (found != built.end())
+    {
+        return found->second;
+    }
+    int index = states.size();
+    states.emplace_back();
+    built[key] = index;
+    const auto& first = get<1>(candidates[0]);
+    if (first.empty())
+    {
+        states[index].accept = get<0>(candidates[0]);
+        return index;
+    }
+    auto path = first[0].path;
+
+    vector<string> labels;
+    for (const auto& candidate : candidates)
+    {
+        auto check = checkOn(get<1>(candidate), path);
+        if (check != nullptr and not check->any and not contains(labels, check->label))
+        {
+            labels.push_back(check->label);
+        }
+    }
+    // Follows the candidates that can still match, given the symbol at path: labelled label, any other single symbol, or none
+    const auto follow = [&](const string* label, bool single)
+    {
+        Candidates remaining;
+        for (const auto& candidate : candidates)
+        {
+            auto check = checkOn(get<1>(candidate), path);
+            if (check == nullptr)
+            {
+                remaining.push_back(candidate);
+            }
+            else if (single and (check->any or (label != nullptr and check->label == *label)))
+            {
+                remaining.push_back(make_tuple(get<0>(candidate), without(get<1>(candidate), check)));
+            }
+        }
+        return build(remaining, built);
+    };
+    for (const auto& label : labels)
+    {
+        int next = follow(&label, true);
+        states[index].edges[label] = next;
+    }
+    int other  = follow(nullptr, true);
+    int absent = follow(nullptr, false);
+    states[index].path   = path;
+    states[index].other  = other;
+    states[index].absent = absent;
+    return index;
+}
+
+/**
+ * Finds the rule matching a node
+ * @return Index of the first rule that matches, or -1
+ */
+int RewriteAutomaton::match(const string& tag, MultiSymbolTable& ms_table) const
+{
+    int state = states.empty() ? -1 : 0;
+    while (state != -1 and states[state].accept == -1)
+    {
+        const auto& current = states[state];
+        if (current.path.empty())
+        {
+            auto found = current.edges.find(tag);
+            state = found == current.edges.end() ? current.other : found->second;
+            continue;
+        }
+        auto symbol = symbolAt(ms_table, current.path);
+        if (symbol == nullptr)
+        {
+            state = current.absent;
+            continue;
+        }
+        auto multi = dynamic_cast<MultiSymbol*>(symbol);
+        auto found = current.edges.find(multi == nullptr ? symbol->name() : multi->tag);
+        state = found == current.edges.end() ? current.other : found->second;
+    }
+    return state == -1 ? -1 : states[state].accept;
+}
+
+/**
+ * Rewrites a node in place with the first rule that matches it
+ * @param tag Tag of the node
+ * @param ms_table Table of the node
+ * @return true if a rule was applied
+ */
+bool RewriteAutomaton::operator()(string& tag, MultiSymbolTable& ms_table) const
+{
+    auto matched = match(tag, ms_table);
+    if (matched == -1)
+    {
+        return false;
+    }
+    const auto& rule = rules[matched];
+    if (not rule.retag_only)
+    {
+        unordered_map<string, SymbolList> captured; // Copied out before the table is replaced
+        for (const auto& capture : rule.captures)
+        {
+            captured[get<0>(capture)] = symbolsAt(ms_table, get<1>(capture));
+        }
+        MultiSymbolTable table;
+        for (const auto& entry : rule.table)
+        {
+            table[get<0>(entry)] = captured[get<1>(entry)];
+        }
+        ms_table = std::move(table);
+    }
+    tag = rule.tag;
+    return true;
+}
+
+bool RewriteAutomaton::empty() const
+{
+    return rules.empty();
+}
+
+/// Number of states in the decision tree
+size_t RewriteAutomaton::size() const
+{
+    return states.size();
+}
+
+}
@@ -0,0 +1,80 @@
+/// Copyright 2017 Lucas Saldyt
+#pragma once
+#include "../syntax/types.hpp"
+
+namespace transform
+{
+
+using namespace syntax;
+using namespace tools;
+
+/// Keys followed from a node down to one of its descendants, each through a tag holding a single symbol
+using PatternPath = vector<int>;
+
+/**
+ * Condition on the symbol at a path: it must be the only symbol under its tag, and, unless any is set,
+ * have the given label (the tag of a MultiSymbol, or the name of any other symbol)
+ */
+struct PatternCheck
+{
+    PatternPath path;
+    string label;
+    bool any = false;
+};
+
+/**
+ * A tree-pattern rewrite rule, i.e.
+ *   forloop(loopvar=$var, loopexpr=functioncall(identifier=range, args=$count), loopbody=$body*) -> forrange(loopvar=$var, count=$count, body=$body)
+ * In a pattern, tag=name matches a single symbol labelled name, tag=name(...) also matches its children,
+ * tag=$x captures a single symbol, tag=$x* captures every symbol under the tag (if any), and tag=_ matches any single symbol
+ * The replacement is a tag, which only retags the node, or a tag with a new table built from captures
+ */
+struct RewriteRule
+{
+    string source;
+    vector<PatternCheck> checks;                    // Parents before children, starting with the tag of the node itself
+    vector<tuple<string, PatternPath>> captures;
+    string tag;
+    bool retag_only = true;
+    vector<tuple<int, string>> table;               // Replacement tag, capture name
+};
+
+RewriteRule parseRewriteRule(const string& line);
+
+/**
+ * Every rewrite rule of a language, compiled into a single decision tree
+ * Each state tests the label at one path, so a node is matched against all rules with one test per distinct path,
+ * instead of one rule at a time. When several rules match, the first one in the file wins
+ * States are shared by every path through the tree that leaves the same rules with the same checks, so rules on
+ * unrelated paths add states instead of multiplying them
+ */
+class RewriteAutomaton
+{
+public:
+    RewriteAutomaton();
+    RewriteAutomaton(const vector<string>& lines);
+
+    bool operator()(string& tag, MultiSymbolTable& ms_table) const;
+    int  match(const string& tag, MultiSymbolTable& ms_table) const;
+    bool empty() const;
+    size_t size() const;
+
+private:
+    struct State
+    {
+        PatternPath path;
+        unordered_map<string, int> edges; // Next state by label
+        int other  = -1;                  // Next state for a single symbol with any other label
+        int absent = -1;                  // Next state if the path doesn't lead to a single symbol
+        int accept = -1;                  // Rule matched in this state
+    };
+
+    vector<RewriteRule> rules;
+    vector<State>       states;
+
+    using Candidates = vector<tuple<int, vector<PatternCheck>>>; // Rules that can still match, with the checks they have left
+
+    int build(const Candidates& candidates, unordered_map<string, int>& built);
+};
+
+}
@@ -4,18 +4,100 @@
 
 namespace transform 
 {
-ElementConstructorCreator<vector<string>> ec_creator = [](string s)
+void addNewLine(vector<TransformOp>& generated, int nesting)
+{}
+
+/**
+ * Decodes a transform line, i.e. "transfer-append a boolexpr values"
+ * Keywords are matched in the order they always were, so i.e. "transfer-append" is a transfer
+ * @param terms Whitespace seperated terms of the line
+ * @return Operation with its registers and keys interned
+ */
+TransformOp decodeTransform(const vector<string>& terms)
 {
-    ElementConstructor<vector<string>> ec;
-    ec = [s](unordered_set<string>& names,
+    assert(not terms.empty());
+    TransformOp op;
+    auto keyword = terms[0];
+    if (keyword == "reg" or contains(keyword, "transfer") or contains(keyword, "pushback"))
+    {
+        assert(terms.size() >= 2);
+        op.reg = intern(terms[1]);
+    }
+
+    if (keyword == "createreg")
+    {
+        assert(terms.size() == 2);
+        op.opcode = TransformOpcode::createreg;
+        op.reg    = intern(terms[1]);
+    }
+    else if (keyword == "reg")
+    {
+        op.opcode = TransformOpcode::reg;
+        op.nested.push_back(decodeTransform(slice(terms, 2)));
+    }
+    else if (contains(keyword, "transfer"))
+    {
+        assert(terms.size() == 4);
+        op.opcode = TransformOpcode::transfer;
+        op.source = intern(terms[2]);
+        op.key    = intern(terms[3]);
+        op.append = contains(keyword, "append");
+    }
+    else if (contains(keyword, "add") or contains(keyword, "append"))
+    {
+        assert(terms.size() == 4);
+        op.opcode  = TransformOpcode::add;
+        op.key     = intern(terms[1]);
+        op.creator = &syntax::generatorMap.at(terms[2]);
+        op.text    = terms[3];
+        op.append  = not contains(keyword, "add");
+    }
+    else if (contains(keyword, "copy") or contains(keyword, "move"))
+    {
+        assert(terms.size() == 3);
+        op.opcode = TransformOpcode::copy;
+        op.source = intern(terms[1]);
+        op.key    = intern(terms[2]);
+        op.append = contains(keyword, "append");
+        op.move   = contains(keyword, "move");
+    }
+    else if (contains(keyword, "retag"))
+    {
+        assert(terms.size() == 2);
+        op.opcode = TransformOpcode::retag;
+        op.text   = terms[1];
+    }
+    else if (contains(keyword, "pushback"))
+    {
+        assert(terms.size() == 3 or terms.size() == 4);
+        op.opcode      = TransformOpcode::pushback;
+        op.key         = intern(terms[2]);
+        op.destination = terms.size() == 4 ? intern(terms[3]) : -1;
+        op.replace     = contains(keyword, "override");
+    }
+    else if (contains(keyword, "delete"))
+    {
+        op.opcode = TransformOpcode::remove;
+        op.key    = intern(terms[1]);
+    }
+    else
+    {
+        op.text = keyword;
+    }
+    return op;
+}
+
+ElementConstructorCreator<TransformOp> ec_creator = [](string s, const vector<string>& definitions)
+{
+    auto op = decodeTransform(lex::seperate(s, {make_tuple(" ", false)}));
+    ElementConstructor<TransformOp> ec;
+    ec = [op](Names& names,
               MultiSymbolTable& ms_table,
               string filename,
-              vector<string>& definitions,
               int nesting,
               OutputManager logger)
     {
-        vector<string> terms = lex::seperate(s, {make_tuple(" ", false)});
-        return terms;
+        return op;
     };
     return ec;
 };
@@ -25,7 +107,17 @@ Transformer::Transformer(vector<string> transformer_files, string directory)
     for (auto file : transformer_files)
     {
         auto content = readFile(directory + file);
-        auto constructor = generateTransformConstructor<vector<string>>(content,
+        source_hash = contentHash(file, source_hash);
+        for (const auto& line : content)
+        {
+            source_hash = contentHash(line, source_hash);
+        }
+        if (file == "rewrites")
+        {
+            rewrites = RewriteAutomaton(content);
+            continue;
+        }
+        auto constructor = generateTransformConstructor<TransformOp>(content,
                 ec_creator
                 );
         transformation_map[file] = constructor;
@@ -36,174 +128,211 @@ Transformer::Transformer()
 {
 }
 
-void Transformer::operator()(IdentifiedGroups& identified_groups)
+/// Hash of the transformer files, which changes whenever any of them does
+uint64_t Transformer::sourceHash() const
+{
+    return source_hash;
+}
+
+/// Checks if the transformer has no rules, so applying it wouldn't change anything
+bool Transformer::empty() const
+{
+    return transformation_map.empty() and rewrites.empty();
+}
+
+/**
+ * Transform identified groups in place
+ * @param arena Arena of the file the groups were identified from, new symbols are created in it
+ */
+void Transformer::operator()(IdentifiedGroups& identified_groups, Arena& arena)
 {
     for (auto& id_group : identified_groups)
     {
-        auto& tag      = get<0>(id_group);
-        auto& ms_table = get<1>(id_group);
-        _transform(tag, ms_table);
+        (*this)(id_group, arena);
     }
 }
 
-void Transformer::_keyword_transform(vector<string>& terms, 
+void Transformer::operator()(IdentifiedGroup& identified_group, Arena& arena)
+{
+    auto& tag      = get<0>(identified_group);
+    auto& ms_table = get<1>(identified_group);
+    if (not empty())
+    {
+        _transform(tag, ms_table, arena);
+    }
+}
+
+/**
+ * Applies a decoded transform line to a symbol table
+ * @param op Decoded line
+ * @param otag Tag of the symbol being transformed, or of a register
+ * @param oms_table Table of the symbol being transformed, or of a register
+ * @param register_map Registers of the current transform
+ * @param arena Arena new symbols are created in
+ */
+void Transformer::_keyword_transform(const TransformOp& op, 
                                      string& otag, 
                                      MultiSymbolTable& oms_table,
-                                     RegisterMap& register_map)
+                                     RegisterMap& register_map,
+                                     Arena& arena)
 {
-    assert(not terms.empty());
-    auto keyword = terms[0];
-    bool reg = keyword == "reg" or contains(keyword, "transfer") or contains(keyword, "pushback");
-    assert(terms.size() >= 2);
-    auto reg_name = reg ? terms[1] : "";
-    if (reg) err_if(not contains(register_map, reg_name), "Register " + reg_name + " not found");
-    auto& reg_tag      = reg ? get<0>(register_map[reg_name]) : otag;
-    auto& reg_ms_table = reg ? get<1>(register_map[reg_name]) : oms_table;
+    bool reg = op.reg != -1 and op.opcode != TransformOpcode::createreg;
+    if (reg) err_if(register_map.count(op.reg) == 0, "Register " + interned(op.reg) + " not found");
+    auto& reg_tag      = reg ? get<0>(register_map[op.reg]) : otag;
+    auto& reg_ms_table = reg ? get<1>(register_map[op.reg]) : oms_table;
 
-    if (keyword == "createreg")
+    switch (op.opcode)
     {
-        assert(terms.size() == 2);
-        register_map[terms[1]] = make_tuple("", MultiSymbolTable());
-        return;
-    }
-    else if (keyword == "reg")
-    {
-        terms = slice(terms, 2);
-        _keyword_transform(terms, reg_tag, reg_ms_table, register_map);
-        return;
-    }
-    else if (contains(keyword, "transfer"))
-    {
-        assert(terms.size() == 4);
-        auto a = terms[2];
-        auto b = terms[3];
-        err_if(not contains(oms_table, a), a + " not in original table");
-        if (contains(keyword, "append"))
+        case TransformOpcode::createreg:
         {
-            assert(contains(reg_ms_table, b));
-            concat(reg_ms_table[b], oms_table[a]);
+            register_map[op.reg] = make_tuple("", MultiSymbolTable());
+            break;
         }
-        else
+        case TransformOpcode::reg:
         {
-            reg_ms_table[b] = oms_table[a];
+            _keyword_transform(op.nested[0], reg_tag, reg_ms_table, register_map, arena);
+            break;
         }
-    }
-    else if (contains(keyword, "add") or contains(keyword, "append"))
-    {
-        assert(terms.size() == 4);
-        auto creator = syntax::generatorMap.at(terms[2]);
-        auto symbol  = creator({terms[3]});
-        if (contains(keyword, "add") or not contains(oms_table, terms[1]))
-        {
-            assert(not contains(oms_table, terms[1])); // If "add" branch
-            oms_table[terms[1]] = vector<shared_ptr<Symbol>>({symbol});
-        }
-        else
+        case TransformOpcode::transfer:
         {
-            oms_table[terms[1]].push_back(symbol);
-        }
-    }
-    else if (contains(keyword, "copy") or contains(keyword, "move"))
-    {
-        assert(terms.size() == 3);
-        auto a = terms[1];
-        auto b = terms[2];
-        assert(contains(oms_table, a));
-        if (contains(keyword, "append"))
-        {
-            assert(contains(oms_table, b));
-            concat(oms_table[b], oms_table[a]);
-        }
-        else
-        {
-            oms_table[b] = oms_table[a];
+            err_if(not contains(oms_table, op.source), interned(op.source) + " not in original table");
+            auto symbols = oms_table[op.source]; // Copied first, adding key may move the lists of a flat table
+            if (op.append)
+            {
+                assert(contains(reg_ms_table, op.key));
+                concat(reg_ms_table[op.key], symbols);
+            }
+            else
+            {
+                reg_ms_table[op.key] = symbols;
+            }
+            break;
         }
-        if (contains(keyword, "move"))
+        case TransformOpcode::add:
         {
-            oms_table.erase(a);
+            auto symbol = (*op.creator)(arena, {op.text});
+            if (not op.append or not contains(oms_table, op.key))
+            {
+                assert(not contains(oms_table, op.key)); // If "add" branch
+                oms_table[op.key] = SymbolList({symbol});
+            }
+            else
+            {
+                oms_table[op.key].push_back(symbol);
+            }
+            break;
         }
-    }
-    else if (contains(keyword, "retag"))
-    {
-        assert(terms.size() == 2);
-        otag = terms[1];
-    }
-    else if (contains(keyword, "pushback"))
-    {
-        assert(terms.size() == 3 or terms.size() == 4);
-        auto key         = terms[2];
-        auto destination = terms.size() == 4 ? terms[3] : ""s;
-        auto symbol = make_shared<MultiSymbol>(MultiSymbol(reg_tag, reg_ms_table));
-        if (contains(keyword, "override") or not contains(oms_table, key))
+        case TransformOpcode::copy:
         {
-            if (destination.empty())
-            { 
-                oms_table[key] = vector<shared_ptr<Symbol>>({symbol});
+            assert(contains(oms_table, op.source));
+            auto symbols = oms_table[op.source];
+            if (op.append)
+            {
+                assert(contains(oms_table, op.key));
+                concat(oms_table[op.key], symbols);
             }
             else
             {
-                auto& other_ms_table = get<1>(register_map[destination]);
-                other_ms_table[key] = vector<shared_ptr<Symbol>>({symbol}); 
+                oms_table[op.key] = symbols;
+            }
+            if (op.move)
+            {
+                oms_table.erase(op.source);
             }
+            break;
         }
-        else
+        case TransformOpcode::retag:
         {
-            if (destination.empty())
-            { 
-                oms_table[key].push_back(symbol);
+            otag = op.text;
+            break;
+        }
+        case TransformOpcode::pushback:
+        {
+            auto symbol = arena.make<MultiSymbol>(reg_tag, std::move(reg_ms_table));
+            auto& destination_table = op.destination == -1 ? oms_table : get<1>(register_map[op.destination]);
+            if (op.replace or not contains(oms_table, op.key))
+            {
+                destination_table[op.key] = SymbolList({symbol});
             }
             else
             {
-                auto& other_ms_table = get<1>(register_map[destination]);
-                other_ms_table[key].push_back(symbol); 
+                destination_table[op.key].push_back(symbol);
             }
+            // Reset
+            reg_tag = "";
+            reg_ms_table = MultiSymbolTable();
+            break;
+        }
+        case TransformOpcode::remove:
+        {
+            oms_table.erase(op.key);
+            break;
+        }
+        case TransformOpcode::invalid:
+        {
+            throw named_exception("Invalid keyword transform: " + op.text);
         }
-        // Reset
-        reg_tag = "";
-        reg_ms_table = MultiSymbolTable();
     }
-    else if (contains(keyword, "delete"))
+}
+
+void Transformer::_transform(string& tag, MultiSymbolTable& ms_table, Arena& arena)
+{
+    _apply(tag, ms_table, arena);
+    const function<void(string&, MultiSymbolTable&)> transformNested = [this, &arena](string& nested_tag, MultiSymbolTable& nested_ms_table)
     {
-        oms_table.erase(terms[1]);
-    }
-    else
+        _transform(nested_tag, nested_ms_table, arena);
+    };
+    for (auto kv : ms_table)
     {
-        throw named_exception("Invalid keyword transform: " + keyword);
+        for (auto symbol : kv.second)
+        {
+            symbol->visit(transformNested);
+        }
     }
 }
 
-void Transformer::_transform(string& tag, MultiSymbolTable& ms_table)
+/// Applies the rules for a single node, without descending into its children: a rewrite rule, then the transformer for its tag
+void Transformer::_apply(string& tag, MultiSymbolTable& ms_table, Arena& arena)
 {
-    for (auto kv : transformation_map)
+    rewrites(tag, ms_table);
+    auto found = transformation_map.find(tag);
+    if (found != transformation_map.end())
     {
-        if (kv.first == tag)
-        {
-            RegisterMap reg_map;
-            print("Transforming " + tag);
-            unordered_set<string> names;
-            auto keyword_transforms = kv.second(names, 
+        RegisterMap reg_map;
+        print("Transforming " + tag);
+        Names names;
+        auto keyword_transforms = found->second(names, 
                                                 ms_table, 
                                                 "none"); 
-            for (auto terms : keyword_transforms)
-            {
-                _keyword_transform(terms, tag, ms_table, reg_map);
-            }
+        for (const auto& op : keyword_transforms)
+        {
+            _keyword_transform(op, tag, ms_table, reg_map, arena);
         }
     }
-    for (auto& kv : ms_table)
+}
+
+FusedTransformer::FusedTransformer(Transformer& set_first, Transformer& set_second) :
+    first(set_first),
+    second(set_second)
+{
+}
+
+/**
+ * Transform identified groups in place, as first(identified_groups) followed by second(identified_groups) would
+ * @param arena Arena of the file the groups were identified from, new symbols are created in it
+ */
+void FusedTransformer::operator()(IdentifiedGroups& identified_groups, Arena& arena)
+{
+    for (auto& id_group : identified_groups)
     {
-        for (auto& symbol : kv.second)
-        {
-            auto id_group  = symbol->to_id_group(); 
-            auto& tag      = get<0>(id_group);
-            auto& ms_table = get<1>(id_group);
-            if (tag != "undefined")
-            {
-                _transform(tag, ms_table);
-                symbol->modify_id_group(tag, ms_table);
-            }
-        }
+        (*this)(id_group, arena);
     }
 }
 
+void FusedTransformer::operator()(IdentifiedGroup& identified_group, Arena& arena)
+{
+    first(identified_group, arena);
+    second(identified_group, arena);
+}
+
 }
@@ -2,6 +2,7 @@
 #pragma once
 #include "../gen/read.hpp"
 #include "../grammar/grammar.hpp"
+#include "rewrite.hpp"
 
 namespace transform 
 {
@@ -10,7 +11,41 @@ using namespace gen;
 using namespace grammar;
 
 using Register    = tuple<string, MultiSymbolTable>;
-using RegisterMap = unordered_map<string, Register>; 
+using RegisterMap = unordered_map<int, Register>; // By interned register name
+
+enum class TransformOpcode
+{
+    createreg,
+    reg,
+    transfer,
+    add,
+    copy,
+    retag,
+    pushback,
+    remove,
+    invalid    // Unknown keyword, which throws when applied
+};
+
+/**
+ * A line of a transformer file, decoded when the file is loaded
+ * Registers and table keys are interned, so applying it doesn't parse or compare any text
+ */
+struct TransformOp
+{
+    TransformOpcode opcode = TransformOpcode::invalid;
+    bool append  = false;  // transfer, add, copy: add to the symbols under key instead of replacing them
+    bool move    = false;  // copy: erase source afterwards
+    bool replace = false;  // pushback: replace the symbols under key ("override")
+    int reg         = -1;  // createreg, reg, transfer, pushback
+    int source      = -1;  // transfer, copy
+    int key         = -1;  // transfer, add, copy, pushback, remove
+    int destination = -1;  // pushback into another register, if given
+    string text;           // retag: new tag, add: token text, invalid: the line
+    const SymbolGenerator* creator = nullptr; // add
+    vector<TransformOp> nested;               // reg: the transform applied to the register
+};
+
+void addNewLine(vector<TransformOp>& generated, int nesting);
 
 template <typename T>
 Constructor<T> generateTransformConstructor(vector<string> content,
@@ -29,16 +64,42 @@ class Transformer
 public:
     Transformer();
     Transformer(vector<string> transformer_files, string directory);
-    void operator()(IdentifiedGroups& identified_groups);
+    void operator()(IdentifiedGroups& identified_groups, Arena& arena);
+    void operator()(IdentifiedGroup& identified_group, Arena& arena);
+    uint64_t sourceHash() const;
+    bool empty() const;
 
 private:
-    unordered_map<string, Constructor<vector<string>>> transformation_map;
-    void _transform(string& tag, MultiSymbolTable& ms_table);
-    void _keyword_transform(vector<string>& terms, 
+    unordered_map<string, Constructor<TransformOp>> transformation_map; // By the tag each transformer applies to
+    RewriteAutomaton rewrites; // From the transformer file named rewrites, if any
+    uint64_t source_hash = hash_seed; // Of every transformer file read
+    void _transform(string& tag, MultiSymbolTable& ms_table, Arena& arena);
+    void _apply(string& tag, MultiSymbolTable& ms_table, Arena& arena);
+    void _keyword_transform(const TransformOp& op, 
                             string& otag, 
                             MultiSymbolTable& oms_table,
-                            RegisterMap& register_map);
+                            RegisterMap& register_map,
+                            Arena& arena);
 
 };
 
+/**
+ * Applies two transformers group by group, i.e. the input language's pre_transformers and the output language's
+ * post_transformers, giving the same AST as running first and then second over every group
+ * Rules of second, like rewrite rules, can read a node's descendants, so first has to finish a whole group before second
+ * sees any of it. Groups are independent, so each is transformed completely while it is still in cache, and the file
+ * isn't walked a second time
+ */
+class FusedTransformer
+{
+public:
+    FusedTransformer(Transformer& set_first, Transformer& set_second);
+    void operator()(IdentifiedGroups& identified_groups, Arena& arena);
+    void operator()(IdentifiedGroup& identified_group, Arena& arena);
+
+private:
+    Transformer& first;
+    Transformer& second;
+};
+
 }
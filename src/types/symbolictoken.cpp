@@ -1,11 +1,21 @@
 /// Copyright 2017 Lucas Saldyt
 #include "symbolictoken.hpp"
 
-SymbolicToken::SymbolicToken(std::shared_ptr<syntax::Symbol> set_value, std::string set_sub_type, std::string set_type, std::string set_text, int set_line)
+SymbolicToken::SymbolicToken(int set_index, int set_type) :
+    index(set_index),
+    type(set_type)
 {
-    value    = set_value;
-    sub_type = set_sub_type;
-    type     = set_type;
-    text     = set_text;
-    line     = set_line;
+}
+
+SymbolicToken::SymbolicToken(syntax::Symbol* set_value, int set_type) :
+    value(set_value),
+    index(-1),
+    type(set_type)
+{
+}
+
+/// Whether this is a discard or seperator marker rather than part of the syntax tree
+bool SymbolicToken::marker() const
+{
+    return index == discarded or index == seperator;
 }
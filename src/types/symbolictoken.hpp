@@ -8,15 +8,22 @@ class Symbol;
 }
 
 /**
- * Higher level representation of syntactic elements. 
- * Contains type annotations, original text, and an abstract Symbol construction representing the syntax element
+ * Reference to a syntactic element consumed by the parser
+ * Either a token of a TokenStream (by index), whose symbol is created on demand,
+ * or a symbol constructed while matching (i.e. a MultiSymbol built from a grammar rule)
+ * Discarded tokens and seperators are marked by sentinel indices, so marking them never allocates
  */
 struct SymbolicToken
 {
-    std::shared_ptr<syntax::Symbol> value;
-    std::string text;
-    std::string sub_type;
-    std::string type;
-    int line;
-    SymbolicToken(std::shared_ptr<syntax::Symbol> set_value, std::string set_sub_type, std::string set_type, std::string set_text, int set_line=-1);
+    syntax::Symbol* value = nullptr; // Constructed symbol, owned by the stream's arena. Empty for stream tokens
+    int index; // Position in the token stream, -1 for constructed symbols, or one of the marker indices below
+    int type;  // Interned type annotation, i.e. intern("identifier")
+
+    static constexpr int discarded = -2; // Marks a token consumed by a discarded parser (i.e. !punctuator ,)
+    static constexpr int seperator = -3; // Marks the boundary between two repetitions of manySeperated
+
+    SymbolicToken(int set_index, int set_type=-1);
+    SymbolicToken(syntax::Symbol* set_value, int set_type);
+
+    bool marker() const;
 };
@@ -0,0 +1,116 @@
+/// Copyright 2017 Lucas Saldyt
+#include "tokenstream.hpp"
+#include "../syntax/symbols/export.hpp"
+
+TokenStream::TokenStream() : text_offsets(1, 0)
+{
+}
+
+int TokenStream::size() const
+{
+    return types.size();
+}
+
+/// Source line at a position, or -1 past the end of the stream
+int TokenStream::line(int position) const
+{
+    return position < size() ? lines[position] : -1;
+}
+
+std::string TokenStream::tokenText(int position) const
+{
+    return text.substr(text_offsets[position], text_offsets[position + 1] - text_offsets[position]);
+}
+
+/// Content hash of every token's type, sub type, line and text
+uint64_t TokenStream::fingerprint() const
+{
+    uint64_t hash = tools::hash_seed;
+    for (int i = 0; i < size(); i++)
+    {
+        hash = tools::contentHash(tools::interned(types[i]), hash);
+        hash = tools::contentHash(tools::interned(sub_types[i]), hash);
+        hash = tools::contentHash(std::to_string(lines[i]), hash);
+        hash = tools::contentHash(tokenText(i), hash);
+    }
+    return hash;
+}
+
+/**
+ * Retrieve (constructing on first use) the Symbol for a token in the stream
+ */
+syntax::Symbol* TokenStream::symbol(int position)
+{
+    auto& value = symbols[position];
+    if (not value)
+    {
+        auto& generator = syntax::generatorMap.at(tools::interned(types[position]));
+        value = generator(arena, {tokenText(position)});
+        value->line = lines[position];
+    }
+    return value;
+}
+
+/// Symbol for a consumed token, whether it was constructed or refers to the stream
+syntax::Symbol* TokenStream::symbol(const SymbolicToken& token)
+{
+    return token.index < 0 ? token.value : symbol(token.index);
+}
+
+/// Symbol for a token if it has already been constructed, otherwise nullptr
+syntax::Symbol* TokenStream::cachedSymbol(int position) const
+{
+    return symbols[position];
+}
+
+/**
+ * Append a lexed token, checking that a Symbol can later be generated for it
+ */
+void TokenStream::push_back(const Token& token)
+{
+    std::string token_text;
+    for (auto v : token.values)
+    {
+        token_text += v;
+    }
+    if (syntax::generatorMap.find(token.type) == syntax::generatorMap.end())
+    {
+        throw tools::named_exception("Failed to generate type from \"" + 
+                                      token_text + "\", (type: " + token.type + "), " + 
+                                      "(subtype: " + token.sub_type + ")");
+    }
+    types.push_back(tools::intern(token.type));
+    sub_types.push_back(tools::intern(token.sub_type));
+    lines.push_back(token.line);
+    text += token_text;
+    text_offsets.push_back(text.size());
+    symbols.push_back(nullptr);
+}
+
+/// Append a newline token, used by languages where newlines are significant
+void TokenStream::pushNewline(int line)
+{
+    static const int newline_id = tools::intern("newline");
+    types.push_back(newline_id);
+    sub_types.push_back(newline_id);
+    lines.push_back(line);
+    text += "\n";
+    text_offsets.push_back(text.size());
+    symbols.push_back(nullptr);
+}
+
+/**
+ * Free every symbol created since a mark was taken on the arena
+ * Used once the statements starting at begin have been compiled. Parsing never looks behind its start position,
+ * so all symbols cached since the mark belong to tokens from begin onwards, and are rebuilt if needed again
+ * @param begin Position of the first token parsed after the mark
+ * @param mark  Taken from arena before parsing from begin
+ */
+void TokenStream::releaseSymbols(int begin, tools::Arena::Mark mark)
+{
+    for (int i = begin; i < size(); i++)
+    {
+        symbols[i] = nullptr;
+    }
+    arena.rewind(mark);
+}
@@ -0,0 +1,38 @@
+/// Copyright 2017 Lucas Saldyt
+#pragma once
+#include "import.hpp"
+#include "token.hpp"
+#include "symbolictoken.hpp"
+
+/**
+ * Joined stream of lexed tokens, stored as parallel arrays
+ * Matching only looks at type and sub type, which are kept as dense arrays of interned ids.
+ * Token text lives in one shared buffer, and the Symbol for a token is only constructed once the parser keeps it
+ * Every Symbol of the file, including those built by the parser and transformers, lives in the stream's arena
+ */
+struct TokenStream
+{
+    std::vector<int> types;        // Interned type of each token, i.e. intern("operator")
+    std::vector<int> sub_types;    // Interned sub type of each token, i.e. intern("+")
+    std::vector<int> lines;        // Source line of each token
+    std::vector<int> text_offsets; // Start of each token's text in text, plus one trailing end offset
+    std::string      text;
+    tools::Arena     arena;        // Owns the file's AST, released along with the stream
+
+    TokenStream();
+
+    int size() const;
+    int line(int position) const;
+    std::string tokenText(int position) const;
+    uint64_t fingerprint() const;
+    syntax::Symbol* symbol(int position);
+    syntax::Symbol* symbol(const SymbolicToken& token);
+    syntax::Symbol* cachedSymbol(int position) const;
+
+    void push_back(const Token& token);
+    void pushNewline(int line);
+    void releaseSymbols(int begin, tools::Arena::Mark mark);
+
+private:
+    std::vector<syntax::Symbol*> symbols; // Lazily created, see symbol()
+};
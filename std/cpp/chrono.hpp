@@ -1,5 +1,11 @@
+#pragma once
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
 #include <iostream>
+#include <map>
+#include <string>
+#include <vector>
 
 auto time()
 {
@@ -11,3 +17,99 @@ std::ostream& operator <<(std::ostream& os, const std::chrono::duration<long int
     os << std::chrono::duration_cast<std::chrono::duration<double>>(t).count();
     return os;
 }
+
+// Timers and call counters for code generated with --instrument, which prints a flat profile at exit
+namespace __profile__
+{
+    using clock = std::chrono::steady_clock;
+
+    struct Entry
+    {
+        long calls  = 0;
+        int  active = 0; // Calls in progress, so that recursive calls only count towards total time once
+        clock::duration total = clock::duration::zero(); // Time from entering to leaving, including callees
+        clock::duration self  = clock::duration::zero(); // Time not spent in other timed functions or loops
+    };
+
+    class Profile
+    {
+    public:
+        std::map<std::string, Entry> entries; // Entries stay where they are, so counters can keep pointers to them
+
+        ~Profile()
+        {
+            std::vector<std::pair<std::string, Entry>> sorted(entries.begin(), entries.end());
+            std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b){ return a.second.self > b.second.self; });
+            const auto seconds = [](clock::duration d){ return std::chrono::duration_cast<std::chrono::duration<double>>(d).count(); };
+            std::fprintf(stderr, "\nFlat profile:\n%12s %12s %12s  %s\n", "self (s)", "total (s)", "calls", "name");
+            for (const auto& kv : sorted)
+            {
+                std::fprintf(stderr, "%12.6f %12.6f %12ld  %s\n", seconds(kv.second.self), seconds(kv.second.total), kv.second.calls, kv.first.c_str());
+            }
+        }
+    };
+
+    inline Profile& profile()
+    {
+        static Profile instance;
+        return instance;
+    }
+
+    /**
+     * Statistics of one function or loop, declared static where it starts
+     * Instantiations of the same template, and loops with the same name, share an entry
+     */
+    struct Counter
+    {
+        Entry* entry;
+        Counter(const std::string& name, int line=0) :
+            entry(&profile().entries[line > 0 ? name + " (line " + std::to_string(line) + ")" : name])
+        {
+        }
+    };
+
+    /**
+     * Times a call or a loop, from construction to the end of its scope
+     */
+    class ScopedTimer
+    {
+    public:
+        ScopedTimer(Counter& counter) :
+            entry(counter.entry),
+            parent(current()),
+            start(clock::now())
+        {
+            entry->calls++;
+            entry->active++;
+            current() = this;
+        }
+
+        ~ScopedTimer()
+        {
+            auto elapsed = clock::now() - start;
+            entry->active--;
+            if (entry->active == 0)
+            {
+                entry->total += elapsed;
+            }
+            entry->self += elapsed - children;
+            if (parent != nullptr)
+            {
+                parent->children += elapsed;
+            }
+            current() = parent;
+        }
+
+    private:
+        Entry*       entry;
+        ScopedTimer* parent;
+        clock::time_point start;
+        clock::duration   children = clock::duration::zero();
+
+        static ScopedTimer*& current()
+        {
+            static ScopedTimer* timer = nullptr;
+            return timer;
+        }
+    };
+}
@@ -0,0 +1,116 @@
+#include "catch.hpp"
+#include "../src/ast/astfile.hpp"
+#include "../src/ast/fork.hpp"
+#include "../src/syntax/syntax.hpp"
+#include "../src/gen/sourcemap.hpp"
+
+TEST_CASE("Binary ASTs load back as they were written")
+{
+    using namespace ast;
+
+    Arena arena;
+    Symbol* name = arena.make<Identifier>("x");
+    name->line = 3;
+    MultiSymbolTable value_table;
+    value_table["val"] = SymbolList({arena.make<Integer>(-2), arena.make<Double>(0.5), arena.make<StringLiteral>("+")});
+    MultiSymbolTable table;
+    table["identifier"] = SymbolList({name});
+    table["value"]      = SymbolList({arena.make<MultiSymbol>("expression", value_table)});
+    table["copy"]       = SymbolList({name});
+    IdentifiedGroups written = {make_tuple("assignment"s, table)};
+
+    string path = "glossa_ast_test.gast";
+    writeAST(written, path);
+    {
+        ASTFile file(path);
+        REQUIRE(file.header().group_count == 1);
+        REQUIRE(file.header().node_count == 6); // x is only written once, and the group is a node too
+
+        Arena load_arena;
+        auto loaded = file.load(load_arena);
+        REQUIRE(loaded.size() == 1);
+        REQUIRE(get<0>(loaded[0]) == "assignment");
+        auto& loaded_table = get<1>(loaded[0]);
+        REQUIRE(loaded_table["identifier"][0] == loaded_table["copy"][0]);
+        REQUIRE(loaded_table["identifier"][0]->name() == "x");
+        REQUIRE(loaded_table["identifier"][0]->line == 3);
+        REQUIRE(loaded_table["value"][0]->line == -1);
+        REQUIRE(loaded_table["value"][0]->abstract() == table["value"][0]->abstract());
+    }
+
+    writeFile({"not an ast"}, path);
+    REQUIRE_THROWS_AS(ASTFile{path}, named_exception);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Identical subtrees hash the same and compare equal")
+{
+    using namespace syntax;
+
+    Arena arena;
+    const auto call = [&](string name, int arg)
+    {
+        MultiSymbolTable table;
+        table["identifier"] = SymbolList({arena.make<Identifier>(name)});
+        table["args"]       = SymbolList({arena.make<Integer>(arg)});
+        return arena.make<MultiSymbol>("functioncall", table);
+    };
+    REQUIRE(call("len", 1)->hash() == call("len", 1)->hash());
+    REQUIRE(call("len", 1)->hash() != call("len", 2)->hash());
+    REQUIRE(call("len", 1)->hash() != call("size", 1)->hash());
+    REQUIRE(arena.make<Identifier>("x")->hash() != arena.make<StringLiteral>("x")->hash());
+
+    // Memoized code is only reused for a subtree that really has the same structure, not just the same hash
+    REQUIRE(call("len", 1)->sameStructure(*call("len", 1)));
+    REQUIRE(not call("len", 1)->sameStructure(*call("len", 2)));
+    REQUIRE(not arena.make<Identifier>("x")->sameStructure(*arena.make<StringLiteral>("x")));
+}
+
+TEST_CASE("Source maps take line markers out of generated code")
+{
+    using namespace gen;
+
+    SourceMap directives("a.py", "a.cpp", "lines");
+    REQUIRE(directives.apply("    " + lineMarker(4) + "f();") == "#line 4 \"a.py\"\n    f();");
+    REQUIRE(directives.apply("g(" + lineMarker(5) + "x);") == "g(x);");
+
+    SourceMap json("a.py", "a.cpp", "json");
+    REQUIRE(json.apply("#include \"a.hpp\"") == "#include \"a.hpp\"");
+    REQUIRE(json.apply("{\n" + lineMarker(7) + "x = 1;\n}") == "{\nx = 1;\n}");
+
+    SourceMap none("a.py", "a.cpp", "");
+    REQUIRE(none.apply(lineMarker(1)) == lineMarker(1));
+}
+
+TEST_CASE("Forked ASTs take leaves from their own token stream, and can be changed on their own")
+{
+    using namespace ast;
+
+    TokenStream from;
+    TokenStream to;
+    from.push_back(Token({"append"}, "append", "identifier", 1));
+    to.push_back(Token({"push_back"}, "append", "identifier", 1));
+
+    Arena arena;
+    Symbol* added = arena.make<Identifier>("y");
+    MultiSymbolTable call_table;
+    call_table["identifier"] = SymbolList({from.symbol(0)});
+    call_table["args"]       = SymbolList({added});
+    auto call = arena.make<MultiSymbol>("functioncall", call_table);
+    MultiSymbolTable table;
+    table["value"] = SymbolList({call});
+    table["copy"]  = SymbolList({call});
+    IdentifiedGroups original = {make_tuple("statement"s, table)};
+
+    auto forked = forkAST(original, to.arena, from, to);
+    auto& forked_table = get<1>(forked[0]);
+    auto forked_call   = dynamic_cast<MultiSymbol*>(forked_table["value"][0]);
+    REQUIRE(forked_call != call);
+    REQUIRE(forked_table["copy"][0] == forked_call);
+    REQUIRE(forked_call->table["identifier"][0]->name() == "push_back");
+    REQUIRE(forked_call->table["args"][0] == added);
+
+    forked_call->table["args"] = SymbolList();
+    REQUIRE(call->table["args"].size() == 1);
+    REQUIRE(call->table["identifier"][0]->name() == "append");
+}
@@ -0,0 +1,225 @@
+#include "catch.hpp"
+#include "../src/compiler.hpp"
+#include <filesystem>
+#include <sstream>
+#include <sys/stat.h>
+
+namespace
+{
+    using namespace compiler;
+    namespace fs = std::filesystem;
+
+    /**
+     * Directory with its own copy of the languages, which tests compile in and may change, removed afterwards
+     * Tests run from the repository root, where the languages are
+     */
+    class Workspace
+    {
+    public:
+        Workspace(string name) :
+            previous(fs::current_path()),
+            root(previous / name)
+        {
+            fs::remove_all(root);
+            fs::create_directories(root / "input");
+            fs::copy(previous / "languages", root / "languages", fs::copy_options::recursive);
+            fs::current_path(root);
+            cout_buffer = std::cout.rdbuf(quiet.rdbuf()); // Loading a language prints every file it reads
+        }
+
+        ~Workspace()
+        {
+            std::cout.rdbuf(cout_buffer);
+            fs::current_path(previous);
+            fs::remove_all(root);
+        }
+
+        /// Compiles input/file from python3 to cpp into a new output directory, and returns the header and source it generated
+        string compile(const string& file, const string& output, CompilerOptions options=CompilerOptions())
+        {
+            fs::create_directories(output);
+            compileFiles({file}, "input", "python3", output, "cpp", 0, options);
+            string code;
+            for (auto extension : {".hpp", ".cpp"})
+            {
+                for (const auto& line : readFile(output + "/" + file + extension))
+                {
+                    code += line + "\n";
+                }
+            }
+            return code;
+        }
+
+    private:
+        fs::path previous;
+        fs::path root;
+        std::ostringstream quiet;
+        std::streambuf* cout_buffer;
+    };
+
+    /// Several top-level statements, in the annotated form that python inputs are compiled from (see scripts/annotate.py)
+    const vector<string> program = {
+        "import math",
+        "",
+        "def square(x):",
+        "",
+        "    return x * x",
+        "",
+        "end",
+        "def main():",
+        "",
+        "    values = [1, 2, 3]",
+        "",
+        "    total = 0",
+        "",
+        "    for v in values:",
+        "",
+        "        total = total + square(v)",
+        "",
+        "end",
+        "    for i in range(len(values)):",
+        "",
+        "        print(values[i])",
+        "",
+        "end",
+        "    print(total)",
+        "",
+        "end",
+        "if __name__ == \"__main__\":",
+        "",
+        "    main()",
+        "",
+        "end"};
+
+    vector<fs::path> cachedASTs(const string& directory)
+    {
+        vector<fs::path> paths;
+        for (const auto& entry : fs::directory_iterator(directory))
+        {
+            paths.push_back(entry.path());
+        }
+        return paths;
+    }
+
+    ino_t inode(const fs::path& path)
+    {
+        struct stat info;
+        stat(path.c_str(), &info);
+        return info.st_ino;
+    }
+}
+
+TEST_CASE("Numeric options must be numbers in their range")
+{
+    const auto read = [](string arg)
+    {
+        vector<string> args = {"0", arg, "python3"};
+        auto options = readOptions(args);
+        REQUIRE(args.size() == 2);
+        return options;
+    };
+    REQUIRE(read("--max-steps=1000").max_steps == 1000);
+    REQUIRE(read("--max-time=2.5").max_seconds == 2.5);
+    REQUIRE(read("--max-time=0").max_seconds == 0.);
+    REQUIRE(read("--jobs=3").jobs == 3);
+
+    for (auto arg : {"--max-steps=abc", "--max-steps=10k", "--max-steps=-1", "--max-steps=", "--max-time=-0.5",
+                     "--max-time=nan", "--jobs=0", "--jobs=-2", "--jobs=two"})
+    {
+        REQUIRE_THROWS_AS(read(arg), named_exception);
+    }
+}
+
+TEST_CASE("Universal ASTs are cached, and only reused for the same tokens, grammar and pre_transformers")
+{
+    Workspace workspace("glossa_cache_test");
+    writeFile(program, "input/program");
+    CompilerOptions options;
+    options.ast_cache = "cache";
+
+    // Cold, then warm: a hit reads the cached file instead of writing it again
+    auto uncached = workspace.compile("program", "plain");
+    auto cold = workspace.compile("program", "cold", options);
+    REQUIRE(contains(cold, "square"s));
+    REQUIRE(cold == uncached);
+    REQUIRE(cachedASTs("cache").size() == 1);
+    auto cached = cachedASTs("cache")[0];
+    auto written = inode(cached);
+    REQUIRE(workspace.compile("program", "warm", options) == cold);
+    REQUIRE(inode(cached) == written);
+
+    // A corrupt file is ignored, and replaced by a valid one
+    writeFile({"not an AST"}, cached.string());
+    REQUIRE(workspace.compile("program", "corrupt", options) == cold);
+    REQUIRE(readFile(cached.string())[0].rfind("GLOSSAST", 0) == 0);
+    written = inode(cached);
+    REQUIRE(workspace.compile("program", "repaired", options) == cold);
+    REQUIRE(inode(cached) == written);
+
+    // Changed grammars and pre_transformers key new entries, even when they identify the same AST
+    auto grammar = readFile("languages/python3/grammar");
+    grammar.push_back("pass: 'pass'");
+    writeFile(grammar, "languages/python3/grammar");
+    REQUIRE(workspace.compile("program", "grammar", options) == cold);
+    REQUIRE(cachedASTs("cache").size() == 2);
+
+    writeFile({"defines", "transform:"}, "languages/python3/pre_transformers/comment");
+    writeFile({"comment"}, "languages/python3/pre_transformers/core");
+    REQUIRE(workspace.compile("program", "pre_transformers", options) == cold);
+    REQUIRE(cachedASTs("cache").size() == 3);
+}
+
+TEST_CASE("Streaming compiles give the same code, and release each statement's symbols")
+{
+    Workspace workspace("glossa_stream_test");
+    writeFile(program, "input/program");
+    CompilerOptions options;
+    options.stream = true;
+    REQUIRE(workspace.compile("program", "streamed", options) == workspace.compile("program", "whole"));
+
+    auto grammar = loadGrammar("python3");
+    auto lexmap  = buildLexMap("languages/python3/lex/", grammar.keywords);
+    auto pre_transformer = loadTransformer("python3", "pre_");
+    Target target("python3", "cpp", CompilerOptions());
+    PassManager passes;
+    vector<string> logs;
+    compileStreaming("program", grammar, target.generator, lexmap, pre_transformer, target.post_transformer, passes,
+                     target.symbol_table, "input", "streamed", OutputManager(2).buffered(logs));
+
+    // The arena goes back to where it was before each statement, so memory doesn't grow with the number of statements
+    vector<string> released;
+    for (const auto& line : logs)
+    {
+        if (contains(line, "Released statement"s))
+        {
+            released.push_back(line);
+        }
+    }
+    REQUIRE(released.size() == 4);
+    for (const auto& line : released)
+    {
+        REQUIRE(line == released[0]);
+    }
+}
+
+TEST_CASE("Compiling groups on several threads gives the same code as one thread")
+{
+    Workspace workspace("glossa_jobs_test");
+    writeFile(program, "input/program");
+    CompilerOptions options;
+    options.jobs = 4;
+    auto single = workspace.compile("program", "single");
+    auto parallel = workspace.compile("program", "parallel", options);
+    REQUIRE(parallel == single);
+
+    // Only the first group carries the file's default content, wherever its thread finished
+    REQUIRE(parallel.rfind("#pragma once\n", 0) == 0);
+    REQUIRE(parallel.find("#pragma once", 1) == string::npos);
+
+    // Passes and the post_transformers allocate in a separate arena per thread, which has to outlive generation
+    CompilerOptions passes;
+    passes.passes = {"constant-folding", "type-inference", "signature-inference"};
+    auto single_passes = workspace.compile("program", "single_passes", passes);
+    passes.jobs = 4;
+    REQUIRE(workspace.compile("program", "parallel_passes", passes) == single_passes);
+}
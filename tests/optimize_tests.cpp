@@ -0,0 +1,210 @@
+#include "catch.hpp"
+#include "../src/optimize/passes.hpp"
+#include "../src/syntax/syntax.hpp"
+
+TEST_CASE("Passes fold constants, remove dead branches and unused assignments")
+{
+    using namespace optimize;
+
+    Arena arena;
+    OutputManager logger(0);
+    const auto node = [&](string tag, vector<tuple<string, SymbolList>> entries)
+    {
+        MultiSymbolTable table;
+        for (auto& entry : entries)
+        {
+            table[get<0>(entry)] = get<1>(entry);
+        }
+        return arena.make<MultiSymbol>(tag, table);
+    };
+    const auto value = [&](Symbol* leaf)
+    {
+        return node("value", {make_tuple("val", SymbolList({node("basevalue", {make_tuple("val", SymbolList({leaf}))})}))});
+    };
+    const auto op = [&](string text){ return arena.make<Operator>(text); };
+    const auto condition = [&](Symbol* leaf)
+    {
+        return node("boolexpression", {make_tuple("body", SymbolList({node("expression", {make_tuple("body", SymbolList({value(leaf)}))})}))});
+    };
+    const auto assign = [&](string name, SymbolList body)
+    {
+        auto rval = node("expression", {make_tuple("body", body)});
+        return node("statement", {make_tuple("val", SymbolList({node("assignment", {
+            make_tuple("lval", SymbolList({arena.make<Identifier>(name)})),
+            make_tuple("op",   SymbolList({op("=")})),
+            make_tuple("rval", SymbolList({rval}))})}))});
+    };
+
+    // x = 2 * 3 + y, z = 7 / 2 (integer division isn't folded), w = 1 + 1, all in an if True:
+    auto folded   = assign("x", {value(arena.make<Integer>(2)), op("*"), value(arena.make<Integer>(3)), op("+"), value(arena.make<Identifier>("y"))});
+    auto unfolded = assign("z", {value(arena.make<Integer>(7)), op("/"), value(arena.make<Integer>(2))});
+    auto unused   = assign("w", {value(arena.make<Integer>(1)), op("+"), value(arena.make<Integer>(1))});
+    auto dead     = node("statement", {make_tuple("val", SymbolList({node("if", {
+        make_tuple("condition", SymbolList({condition(arena.make<Identifier>("True"))})),
+        make_tuple("body",      SymbolList({folded, unfolded, unused}))})}))});
+    auto read = node("statement", {make_tuple("val", SymbolList({node("functioncall", {
+        make_tuple("identifier", SymbolList({arena.make<Identifier>("print")})),
+        make_tuple("args",       SymbolList({arena.make<Identifier>("x")}))})}))});
+
+    MultiSymbolTable function;
+    function["identifier"] = SymbolList({arena.make<Identifier>("f")});
+    function["body"]       = SymbolList({dead, read});
+    IdentifiedGroups groups = {make_tuple("function"s, function)};
+
+    const auto rval = [](Symbol* statement)
+    {
+        auto assignment = dynamic_cast<MultiSymbol*>(dynamic_cast<MultiSymbol*>(statement)->table["val"][0]);
+        return dynamic_cast<MultiSymbol*>(assignment->table["rval"][0])->table["body"];
+    };
+    REQUIRE(foldConstants(groups[0], arena, logger) == 2);
+    REQUIRE(rval(folded).size() == 3);
+    REQUIRE(contains(rval(folded)[0]->abstract(), "(6)"s));
+    REQUIRE(rval(unfolded).size() == 3);
+    REQUIRE(rval(unused).size() == 1);
+
+    REQUIRE(removeDeadBranches(groups[0], arena, logger) == 1);
+    auto& body = get<1>(groups[0])["body"];
+    REQUIRE(body.size() == 4);
+    REQUIRE(body[0] == folded);
+
+    // Only w goes: x is read, and 7 / 2 could raise in the input language
+    REQUIRE(removeUnusedAssignments(groups[0], arena, logger) == 1);
+    REQUIRE(body.size() == 3);
+    REQUIRE(body[2] == read);
+    REQUIRE(removeUnusedAssignments(groups[0], arena, logger) == 0);
+
+    REQUIRE_THROWS_AS(PassManager({"constant-folding", "inlining"}), named_exception);
+}
+
+TEST_CASE("Type inference types lists whose elements are all numbers, unless they escape")
+{
+    using namespace optimize;
+
+    Arena arena;
+    OutputManager logger(0);
+    const auto node = [&](string tag, string key, SymbolList children)
+    {
+        MultiSymbolTable table;
+        table[key] = children;
+        return arena.make<MultiSymbol>(tag, table);
+    };
+    const auto expression = [&](Symbol* leaf)
+    {
+        return node("expression", "body", {node("value", "val", {node("basevalue", "val", {leaf})})});
+    };
+    const auto assign = [&](string name, MultiSymbol* literal)
+    {
+        MultiSymbolTable table;
+        table["lval"] = SymbolList({arena.make<Identifier>(name)});
+        table["op"]   = SymbolList({arena.make<Operator>("=")});
+        table["rval"] = SymbolList({node("boolexpression", "body", {node("expression", "body", {node("value", "val", {literal})})})});
+        return node("statement", "val", {arena.make<MultiSymbol>("assignment", table)});
+    };
+    const auto call = [&](string function, Symbol* arg)
+    {
+        MultiSymbolTable table;
+        table["identifier"] = SymbolList({arena.make<Identifier>(function)});
+        table["args"]       = SymbolList({arg});
+        return arena.make<MultiSymbol>("functioncall", table);
+    };
+
+    // values = [1], values.append(2.5), other = [1], g(other)
+    auto values = node("vector", "values", {expression(arena.make<Integer>(1))});
+    auto other  = node("vector", "values", {expression(arena.make<Integer>(1))});
+    MultiSymbolTable append_table;
+    append_table["access"] = SymbolList({node("lvalue", "val", {arena.make<Identifier>("values")})});
+    append_table["member"] = SymbolList({call("push_back", expression(arena.make<Double>(2.5)))});
+
+    MultiSymbolTable function;
+    function["identifier"] = SymbolList({arena.make<Identifier>("f")});
+    function["body"]       = SymbolList({assign("values", values),
+                                         node("statement", "val", {arena.make<MultiSymbol>("memberaccess", append_table)}),
+                                         assign("other", other),
+                                         node("statement", "val", {call("g", expression(arena.make<Identifier>("other")))})});
+    IdentifiedGroups groups = {make_tuple("function"s, function)};
+
+    REQUIRE(inferTypes(groups[0], arena, logger) == 1);
+    REQUIRE(values->table["elementtype"][0]->name() == "float");
+    REQUIRE(not contains(other->table, "elementtype"));
+}
+
+TEST_CASE("Signature inference types functions whose every call passes the same types")
+{
+    using namespace optimize;
+
+    Arena arena;
+    OutputManager logger(0);
+    const auto node = [&](string tag, vector<tuple<string, SymbolList>> entries)
+    {
+        MultiSymbolTable table;
+        for (auto& entry : entries)
+        {
+            table[get<0>(entry)] = get<1>(entry);
+        }
+        return arena.make<MultiSymbol>(tag, table);
+    };
+    const auto expression = [&](SymbolList body)
+    {
+        return node("expression", {make_tuple("body", body)});
+    };
+    const auto value = [&](Symbol* leaf)
+    {
+        return node("value", {make_tuple("val", SymbolList({node("basevalue", {make_tuple("val", SymbolList({leaf}))})}))});
+    };
+    const auto call = [&](string function, SymbolList args)
+    {
+        return node("functioncall", {make_tuple("identifier", SymbolList({arena.make<Identifier>(function)})), make_tuple("args", args)});
+    };
+    const auto statement = [&](Symbol* val)
+    {
+        return node("statement", {make_tuple("val", SymbolList({val}))});
+    };
+    const auto returns = [&](SymbolList body)
+    {
+        return statement(node("flow_stmt", {make_tuple("val", SymbolList({node("return", {make_tuple("expression", SymbolList({expression(body)}))})}))}));
+    };
+    const auto function = [&](string name, SymbolList args, SymbolList body)
+    {
+        MultiSymbolTable group;
+        group["val"] = SymbolList({node("function", {
+            make_tuple("identifier", SymbolList({arena.make<Identifier>(name)})),
+            make_tuple("args",       args),
+            make_tuple("body",       body)})});
+        return make_tuple("statement"s, group);
+    };
+
+    // def twice(x): return x * 2, def same(v): return v, def scale(k): return k, and a caller: twice(1.5), same(1),
+    // same(True), scale(1), scale(1.5)
+    IdentifiedGroups groups = {
+        function("twice", {arena.make<Identifier>("x")},
+                 {returns({value(arena.make<Identifier>("x")), arena.make<Operator>("*"), value(arena.make<Integer>(2))})}),
+        function("same", {arena.make<Identifier>("v")}, {returns({value(arena.make<Identifier>("v"))})}),
+        function("scale", {arena.make<Identifier>("k")}, {returns({value(arena.make<Identifier>("k"))})}),
+        function("caller", {}, {statement(call("twice", {expression({value(arena.make<Double>(1.5))})})),
+                                statement(call("same",  {expression({value(arena.make<Integer>(1))})})),
+                                statement(call("same",  {expression({value(arena.make<Identifier>("True"))})})),
+                                statement(call("scale", {expression({value(arena.make<Integer>(1))})})),
+                                statement(call("scale", {expression({value(arena.make<Double>(1.5))})}))})};
+    const auto definition = [&](size_t i)
+    {
+        return dynamic_cast<MultiSymbol*>(get<1>(groups[i])["val"][0]);
+    };
+
+    REQUIRE(inferSignatures(groups, arena, logger) == 2);
+    auto twice = definition(0);
+    REQUIRE(dynamic_cast<MultiSymbol*>(twice->table["returntype"][0])->table["name"][0]->name() == "float");
+    auto parameter = dynamic_cast<MultiSymbol*>(twice->table["params"][0]);
+    REQUIRE(dynamic_cast<MultiSymbol*>(parameter->table["type"][0])->table["name"][0]->name() == "float");
+    REQUIRE(parameter->table["identifier"][0]->name() == "x");
+    REQUIRE(not contains(definition(1)->table, "returntype"));
+
+    // An int argument would be converted to float, so an int caller would get a float back: scale stays a template
+    REQUIRE(not contains(definition(2)->table, "returntype"));
+    REQUIRE(not contains(definition(2)->table, "params"));
+    REQUIRE(dynamic_cast<MultiSymbol*>(definition(3)->table["returntype"][0])->table["name"][0]->name() == "void");
+
+    // Calls are only all known once the whole file is seen, so the pass can't run on one group at a time
+    PassManager passes({"signature-inference"});
+    REQUIRE(passes.needsWholeFile());
+    REQUIRE_THROWS_AS(passes(groups[0], arena, logger), named_exception);
+}
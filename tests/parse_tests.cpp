@@ -0,0 +1,79 @@
+#include "catch.hpp"
+#include "../src/parse/tokenparsers.hpp"
+#include "../src/syntax/syntax.hpp"
+
+TEST_CASE("Token parsers match against token streams")
+{
+    using namespace parse;
+
+    TokenStream tokens;
+    tokens.push_back(Token({"x"}, "x", "identifier", 1));
+    tokens.push_back(Token({"+"}, "+", "operator",   1));
+    tokens.push_back(Token({"2"}, "int", "literal",  2));
+
+    SECTION("terminals compare types and sub types")
+    {
+        REQUIRE(typeParser("identifier")(tokens, 0).result);
+        REQUIRE(dualTypeParser("operator", "+")(tokens, 1).position == 2);
+        REQUIRE(not dualTypeParser("operator", "-")(tokens, 1).result);
+        REQUIRE(not subTypeParser("int")(tokens, 3).result);
+    }
+    SECTION("combinators consume from a position")
+    {
+        auto parser = inOrder({typeParser("identifier"), typeParser("operator"), subTypeParser("int")});
+        auto result = parser(tokens, 0);
+        REQUIRE(result.result);
+        REQUIRE(result.consumed.size() == 3);
+        REQUIRE(result.position == 3);
+        REQUIRE(tokens.symbol(result.consumed[0])->name() == "x");
+        REQUIRE(tokens.tokenText(2) == "2");
+        REQUIRE(not parser(tokens, 1).result);
+    }
+    SECTION("discarded and seperated tokens are marked")
+    {
+        auto parser = manySeperated(anyOf({typeParser("identifier"), discard(typeParser("operator"))}));
+        auto result = parser(tokens, 0);
+        REQUIRE(result.position == 2);
+        REQUIRE(result.consumed.size() == 3);
+        REQUIRE(not result.consumed[0].marker());
+        REQUIRE(result.consumed[1].index == SymbolicToken::seperator);
+        REQUIRE(result.consumed[2].index == SymbolicToken::discarded);
+        REQUIRE(not result.consumed[2].value);
+    }
+}
+
+TEST_CASE("Parse budgets bound matching work")
+{
+    using namespace parse;
+
+    TokenStream tokens;
+    for (int i = 0; i < 10; i++)
+    {
+        tokens.push_back(Token({"x"}, "x", "identifier", i + 1));
+    }
+
+    SECTION("unlimited budgets never run out")
+    {
+        auto budget = make_shared<ParseBudget>();
+        auto parser = manySeperated(budgeted(typeParser("identifier"), budget, "test"));
+        REQUIRE(parser(tokens, 0).position == 10);
+        REQUIRE(budget->steps() == 10);
+    }
+    SECTION("exceeding the step limit names the rule and line")
+    {
+        auto budget = make_shared<ParseBudget>(3);
+        auto parser = manySeperated(budgeted(typeParser("identifier"), budget, "test"));
+        try
+        {
+            parser(tokens, 0);
+            FAIL("Budget was not enforced");
+        }
+        catch (const budget_exceeded& e)
+        {
+            REQUIRE(e.rule == "test");
+            REQUIRE(e.line == 4);
+        }
+        budget->reset();
+        REQUIRE(budget->steps() == 0);
+    }
+}
@@ -0,0 +1,95 @@
+#include "catch.hpp"
+#include "../src/tools/tools.hpp"
+
+namespace
+{
+    struct Counted
+    {
+        int& count;
+        tools::string value;
+        Counted(int& set_count, tools::string set_value) : count(set_count), value(set_value) { count++; }
+        ~Counted() { count--; }
+    };
+}
+
+TEST_CASE("Arenas construct and release objects together")
+{
+    using namespace tools;
+
+    int alive = 0;
+    {
+        Arena arena(64);
+        auto first = arena.make<Counted>(alive, "first");
+        auto mark  = arena.mark();
+        for (int i = 0; i < 10; i++)
+        {
+            arena.make<Counted>(alive, std::to_string(i));
+        }
+        REQUIRE(alive == 11);
+
+        arena.rewind(mark);
+        REQUIRE(alive == 1);
+        REQUIRE(first->value == "first");
+        REQUIRE(arena.used() == mark.offset);
+
+        auto reused = arena.make<Counted>(alive, "reused");
+        REQUIRE(reused->value == "reused");
+        REQUIRE(alive == 2);
+    }
+    REQUIRE(alive == 0);
+}
+
+TEST_CASE("Small vectors spill to the heap only when they outgrow their inline storage")
+{
+    using namespace tools;
+
+    SmallVector<tools::string, 2> values = {"a", "b"};
+    REQUIRE(not values.onHeap());
+    values.push_back("c");
+    REQUIRE(values.onHeap());
+    REQUIRE(values.size() == 3);
+    REQUIRE(values[2] == "c");
+
+    auto moved = std::move(values);
+    REQUIRE(values.empty());
+    REQUIRE(moved.size() == 3);
+
+    concat(moved, moved);
+    moved.erase(moved.begin());
+    REQUIRE(moved.size() == 5);
+    REQUIRE(moved.front() == "b");
+    REQUIRE(moved.back() == "c");
+}
+
+TEST_CASE("Parallel loops visit every index once, and rethrow the first error")
+{
+    using namespace tools;
+
+    vector<int> visits(100, 0);
+    vector<int> workers(100, -1);
+    parallelFor(visits.size(), 4, [&](size_t i, int worker){ visits[i]++; workers[i] = worker; });
+    REQUIRE(std::all_of(visits.begin(), visits.end(), [](int v){ return v == 1; }));
+    REQUIRE(std::all_of(workers.begin(), workers.end(), [](int w){ return w >= 0 and w < 4; }));
+
+    vector<string> lines;
+    OutputManager(1).buffered(lines).log("buffered");
+    REQUIRE(lines == vector<string>({"buffered"}));
+
+    REQUIRE_THROWS_AS(parallelFor(10, 4, [](size_t i, int){ if (i == 3) throw named_exception("failed"); }), named_exception);
+}
+
+TEST_CASE("Emitters write lines through a buffer smaller than the file")
+{
+    using namespace tools;
+
+    string path = "glossa_emitter_test.txt";
+    {
+        Emitter emitter(path, 8);
+        emitter.line("short");
+        emitter.lines({"a line longer than the buffer", "", "end"});
+        auto moved = std::move(emitter);
+        moved.line("after move");
+    }
+    REQUIRE(readFile(path) == vector<string>({"short", "a line longer than the buffer", "", "end", "after move"}));
+    std::remove(path.c_str());
+}
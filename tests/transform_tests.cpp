@@ -0,0 +1,157 @@
+#include "catch.hpp"
+#include "../src/transform/transformer.hpp"
+#include "../src/syntax/syntax.hpp"
+#include <sys/stat.h>
+
+TEST_CASE("Fused transformers match running them one after the other")
+{
+    using namespace transform;
+
+    string directory = "glossa_transform_test/";
+    mkdir(directory.c_str(), 0755);
+    writeFile({"defines", "transform:", "retag functioncall", "move val args", "add identifier identifier print"}, directory + "print");
+    writeFile({"defines", "transform:", "add marker identifier pre"}, directory + "value");
+    Transformer pre({"print", "value"}, directory);
+    // Wraps the arguments of a call in a new symbol, whose children were transformed by pre
+    writeFile({"defines", "transform:", "createreg r", "reg r retag arguments", "transfer r args val", "delete args", "pushback r args"}, directory + "functioncall");
+    writeFile({"defines", "transform:", "add wrapped identifier post"}, directory + "arguments");
+    writeFile({"defines", "transform:", "add checked identifier post"}, directory + "value");
+    Transformer post({"functioncall", "arguments", "value"}, directory);
+    for (auto file : {"print", "value", "functioncall", "arguments"})
+    {
+        std::remove((directory + file).c_str());
+    }
+    rmdir(directory.c_str());
+
+    Arena arena;
+    const auto statement = [&]()
+    {
+        MultiSymbolTable value_table;
+        value_table["val"] = SymbolList({arena.make<Identifier>("x")});
+        MultiSymbolTable print_table;
+        print_table["val"] = SymbolList({arena.make<MultiSymbol>("value", value_table)});
+        MultiSymbolTable table;
+        table["val"] = SymbolList({arena.make<MultiSymbol>("print", print_table)});
+        return IdentifiedGroups({make_tuple("statement"s, table)});
+    };
+    auto sequential = statement();
+    pre(sequential, arena);
+    post(sequential, arena);
+    auto fused = statement();
+    FusedTransformer(pre, post)(fused, arena);
+
+    auto abstract = [](IdentifiedGroups& groups){ return get<1>(groups[0])["val"][0]->abstract(); };
+    REQUIRE(abstract(fused) == abstract(sequential));
+    REQUIRE(contains(abstract(fused), "arguments"s));
+    REQUIRE(contains(abstract(fused), "marker"s));
+    REQUIRE(contains(abstract(fused), "checked"s));
+}
+
+TEST_CASE("Fused transformers finish the first on a group before rewrite rules of the second read it")
+{
+    using namespace transform;
+
+    string directory = "glossa_fused_rewrite_test/";
+    mkdir(directory.c_str(), 0755);
+    writeFile({"defines", "transform:", "retag functioncall"}, directory + "call");
+    Transformer pre({"call"}, directory);
+    // Only matches once pre has retagged the loop's call, which is a descendant of the node the rule applies to
+    writeFile({"forloop(loopvar=$var, loopexpr=functioncall(identifier=range, args=$count)) -> forrange(loopvar=$var, count=$count)"},
+              directory + "rewrites");
+    Transformer post({"rewrites"}, directory);
+    std::remove((directory + "call").c_str());
+    std::remove((directory + "rewrites").c_str());
+    rmdir(directory.c_str());
+
+    Arena arena;
+    const auto loop = [&]()
+    {
+        MultiSymbolTable call_table;
+        call_table["identifier"] = SymbolList({arena.make<Identifier>("range")});
+        call_table["args"]       = SymbolList({arena.make<Identifier>("n")});
+        MultiSymbolTable loop_table;
+        loop_table["loopvar"]  = SymbolList({arena.make<Identifier>("i")});
+        loop_table["loopexpr"] = SymbolList({arena.make<MultiSymbol>("call", call_table)});
+        MultiSymbolTable table;
+        table["val"] = SymbolList({arena.make<MultiSymbol>("forloop", loop_table)});
+        return IdentifiedGroups({make_tuple("statement"s, table)});
+    };
+    auto sequential = loop();
+    pre(sequential, arena);
+    post(sequential, arena);
+    auto fused = loop();
+    FusedTransformer(pre, post)(fused, arena);
+
+    auto abstract = [](IdentifiedGroups& groups){ return get<1>(groups[0])["val"][0]->abstract(); };
+    REQUIRE(contains(abstract(sequential), "forrange"s));
+    REQUIRE(abstract(fused) == abstract(sequential));
+}
+
+TEST_CASE("Rewrite rules match nested patterns, first rule first")
+{
+    using namespace transform;
+
+    RewriteAutomaton rewrites({
+        "forloop(loopvar=$var, loopexpr=functioncall(identifier=range, args=$count), loopbody=$body*) -> forrange(loopvar=$var, count=$count, body=$body)",
+        "",
+        "forloop(loopexpr=functioncall(identifier=_)) -> forcall",
+        "print -> functioncall"});
+
+    Arena arena;
+    const auto loop = [&](string function, int arg_count)
+    {
+        MultiSymbolTable call_table;
+        call_table["identifier"] = SymbolList({arena.make<Identifier>(function)});
+        for (int i = 0; i < arg_count; i++)
+        {
+            call_table["args"].push_back(arena.make<Identifier>("n"));
+        }
+        MultiSymbolTable table;
+        table["loopvar"]  = SymbolList({arena.make<Identifier>("i")});
+        table["loopexpr"] = SymbolList({arena.make<MultiSymbol>("functioncall", call_table)});
+        return table;
+    };
+
+    string tag = "forloop";
+    auto table = loop("range", 1);
+    REQUIRE(rewrites(tag, table));
+    REQUIRE(tag == "forrange");
+    REQUIRE(table.size() == 3);
+    REQUIRE(table["count"][0]->name() == "n");
+    REQUIRE(table["body"].empty());
+
+    tag   = "forloop";
+    table = loop("range", 2); // $count only captures a single symbol
+    REQUIRE(rewrites(tag, table));
+    REQUIRE(tag == "forcall");
+    REQUIRE(contains(table, "loopexpr"));
+
+    tag = "print";
+    REQUIRE(rewrites(tag, table));
+    REQUIRE(tag == "functioncall");
+    REQUIRE(not rewrites(tag, table));
+}
+
+TEST_CASE("Rewrite rules on different paths share states instead of multiplying them")
+{
+    using namespace transform;
+
+    // Each rule tests two paths no other rule tests, so a tree without shared states would double for every rule
+    vector<string> lines;
+    for (int i = 0; i < 16; i++)
+    {
+        auto n = std::to_string(i);
+        lines.push_back("statement(a" + n + "=x, b" + n + "=y) -> rule" + n);
+    }
+    RewriteAutomaton rewrites(lines);
+    REQUIRE(rewrites.size() <= 4 * lines.size());
+
+    Arena arena;
+    MultiSymbolTable table;
+    table["a7"] = SymbolList({arena.make<Identifier>("x")});
+    table["b7"] = SymbolList({arena.make<Identifier>("y")});
+    table["a3"] = SymbolList({arena.make<Identifier>("x")});
+    string tag = "statement";
+    REQUIRE(rewrites(tag, table));
+    REQUIRE(tag == "rule7");
+}